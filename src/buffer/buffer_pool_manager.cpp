@@ -5,22 +5,55 @@ namespace cmudb {
 /**
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * num_instances splits the pool into that many independent instances, each
+ * owning a contiguous slice of the frames
+ * replacer_type picks the replacement policy of every instance
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
 									 DiskManager *disk_manager,
-									 LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager),
-      log_manager_(log_manager) {
-  // a consecutive memory space for buffer pool
+									 LogManager *log_manager,
+									 size_t num_instances,
+									 ReplacerType replacer_type)
+    : pool_size_(pool_size), num_instances_(num_instances),
+      disk_manager_(disk_manager), log_manager_(log_manager),
+      async_in_flight_(0), flusher_running_(false),
+      high_dirty_ratio_(FLUSHER_HIGH_DIRTY_RATIO),
+      low_dirty_ratio_(FLUSHER_LOW_DIRTY_RATIO) {
+  assert(num_instances_ > 0 && num_instances_ <= pool_size_);
+  // a consecutive memory space for buffer pool, the page size is only known
+  // at runtime so the content of the frames lives in an arena of its own,
+  // away from the page metadata. It starts zeroed
+  frames_ = new FrameArena(pool_size_ * PAGE_SIZE, BUFFER_POOL_PREFAULT,
+                           BUFFER_POOL_NUMA_POLICY, BUFFER_POOL_NUMA_NODE);
   pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
-
-  // put all the pages into free list
   for (size_t i = 0; i < pool_size_; ++i) {
-	free_list_->push_back(&pages_[i]);
+    pages_[i].data_ = frames_->GetData() + i * PAGE_SIZE;
+  }
+  instances_ = new BufferPoolInstance[num_instances_];
+
+  size_t offset = 0;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    // spread the remainder over the first instances
+    instance.pool_size_ =
+        pool_size_ / num_instances_ + (i < pool_size_ % num_instances_ ? 1 : 0);
+    instance.pages_ = pages_ + offset;
+    instance.page_table_ = new PageTable(instance.pool_size_);
+    if (replacer_type == ReplacerType::CLOCK) {
+      instance.replacer_ =
+          new ClockReplacer<Page *>(instance.pool_size_, instance.pages_);
+    } else if (replacer_type == ReplacerType::TWO_Q) {
+      instance.replacer_ = new TwoQReplacer<Page *>(instance.pool_size_);
+    } else {
+      instance.replacer_ = new LRUReplacer<Page *>;
+    }
+    instance.free_list_ = new std::list<Page *>;
+
+    // put all the pages of this instance into its free list
+    for (size_t j = 0; j < instance.pool_size_; ++j) {
+      instance.free_list_->push_back(&instance.pages_[j]);
+    }
+    offset += instance.pool_size_;
   }
 }
 
@@ -28,61 +61,185 @@ BufferPoolManager::BufferPoolManager(size_t pool_size,
  * BufferPoolManager Deconstructor
  */
 BufferPoolManager::~BufferPoolManager() {
+  StopFlusherThread();
+  // asynchronous requests still reference the frames
+  while (async_in_flight_ > 0) {
+    std::this_thread::yield();
+  }
+  for (size_t i = 0; i < num_instances_; ++i) {
+    delete instances_[i].page_table_;
+    delete instances_[i].replacer_;
+    delete instances_[i].free_list_;
+  }
+  delete[] instances_;
   delete[] pages_;
-  delete page_table_;
-  delete replacer_;
-  delete free_list_;
+  delete frames_;
+}
+
+/*
+ * Find a frame for page_id, always from free list first, then from lru
+ * replacer. A dirty victim is written back with the instance latch released:
+ * it stays pinned so nobody else picks it, and read latched so the old page
+ * can still be read but not modified while it is being written. A victim
+ * the background flusher is still writing is waited for the same way.
+ * @return: false means all the pages of this instance are pinned. Otherwise
+ * "page" is either a frame ready to be reused (its old page has been removed
+ * from page table), or the frame already holding page_id if another thread
+ * brought it in while the latch was released.
+ * NOTE: caller must hold instance.latch_ through "latch"
+ */
+bool BufferPoolManager::FindVictim(BufferPoolInstance &instance,
+				   std::unique_lock<std::mutex> &latch,
+				   page_id_t page_id, Page *&page) {
+  Page *victim = nullptr;
+  for (;;) {
+    if (victim == nullptr) {
+      if (!instance.free_list_->empty()) {
+	// find from free list
+	victim = instance.free_list_->front();
+	instance.free_list_->pop_front();
+      } else if (!instance.replacer_->Victim(victim)) {
+	// all page are pinned
+	return false;
+      }
+    }
+    if (!victim->is_dirty_ && !victim->write_back_in_flight_) {
+      break;
+    }
+
+    // write back without holding the instance latch
+    victim->pin_count_ = 1;
+    bool is_dirty = victim->is_dirty_;
+    victim->is_dirty_ = false;
+    latch.unlock();
+    if (victim->write_back_in_flight_) {
+      // the flusher releases the read latch once its write completes
+      victim->WLatch();
+      victim->WUnlatch();
+    }
+    if (is_dirty) {
+      victim->RLatch();
+      // write ahead logging, the log records must reach the disk first
+      if (log_manager_ != nullptr && ENABLE_LOGGING &&
+	  victim->GetLSN() > log_manager_->GetPersistentLSN()) {
+	log_manager_->Flush();
+      }
+      disk_manager_->WritePage(victim->page_id_, victim->data_);
+      victim->RUnlatch();
+    }
+    latch.lock();
+
+    if (--victim->pin_count_ > 0) {
+      // the old page got fetched again, leave the frame to its users
+      victim = nullptr;
+    }
+    if (instance.page_table_->Find(page_id, page)) {
+      // someone else brought page_id in meanwhile
+      if (victim != nullptr) {
+	instance.replacer_->Insert(victim);
+      }
+      return true;
+    }
+  }
+
+  if (victim->page_id_ != INVALID_PAGE_ID) {
+    bool removed = instance.page_table_->Remove(victim->page_id_);
+    assert(removed);
+    (void)removed;
+  }
+  page = victim;
+  return true;
 }
 
 /**
  * 1. search hash table.
- *  1.1 if exist, pin the page and return immediately
+ *  1.1 if exist, pin the page and return immediately(if the page is still
+ *      being read by another thread, wait for that frame only)
  *  1.2 if no exist, find a replacement entry from either free list or lru
  *      replacer. (NOTE: always find from free list first)
  * 2. If the entry chosen for replacement is dirty, write it back to disk.
  * 3. Delete the entry for the old page from the hash table and insert an
  * entry for the new page.
- * 4. Update page metadata, read page content from disk file and return page
- * pointer
+ * 4. Update page metadata, read page content from disk file without holding
+ * the instance latch and return page pointer
  */
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
   assert(page_id != INVALID_PAGE_ID);
-  std::lock_guard<std::mutex> latch(latch_);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::unique_lock<std::mutex> latch(instance.latch_);
   Page* page = nullptr;
-  bool ok = page_table_->Find(page_id, page); 
-  
+
+  if (!instance.page_table_->Find(page_id, page) &&
+      !FindVictim(instance, latch, page_id, page)) {
+    return nullptr;
+  }
+
   // if exist, pin the page and return immediately
-  if (ok) {
+  if (page->page_id_ == page_id) {
     if (page->pin_count_ == 0)
-      replacer_->Erase(page); 
-    page->pin_count_ += 1; 
+      instance.replacer_->Erase(page);
+    page->pin_count_ += 1;
+    bool loading = page->io_in_flight_;
+    latch.unlock();
+    if (loading) {
+      // the loading thread releases the write latch once content is valid
+      page->RLatch();
+      page->RUnlatch();
+    }
     return page;
   }
-  
-  if (!free_list_->empty()) {
-    // find from free list
-    page = free_list_->front();
-    free_list_->pop_front();
-  } else {
-    // find from lru replacer 
-    bool ok = replacer_->Victim(page);
-    if (!ok) {
-      // all page are pinned 
-      return nullptr;
-    }
-    assert(page_table_->Remove(page->page_id_)); 
 
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
-    }
-  }
-  
-  page->is_dirty_ = false; 
+  page->is_dirty_ = false;
   page->pin_count_ = 1;
+  page->io_in_flight_ = true;
+  page->WLatch();
   page->page_id_ = page_id;
+  instance.page_table_->Insert(page_id, page);
+  latch.unlock();
+
   disk_manager_->ReadPage(page_id, page->data_);
-						      
-  page_table_->Insert(page_id, page); 
+  page->io_in_flight_ = false;
+  page->WUnlatch();
+  return page;
+}
+
+/*
+ * Pin page_id like FetchPage, but only if it is resident and its content
+ * valid, without any I/O nor waiting
+ * @return: nullptr if the page is not resident or still being read
+ */
+Page *BufferPoolManager::TryFetchPage(page_id_t page_id) {
+  assert(page_id != INVALID_PAGE_ID);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::lock_guard<std::mutex> latch(instance.latch_);
+  Page *page = nullptr;
+
+  if (!instance.page_table_->Find(page_id, page) || page->io_in_flight_) {
+    return nullptr;
+  }
+  if (page->pin_count_ == 0)
+    instance.replacer_->Erase(page);
+  page->pin_count_ += 1;
+  return page;
+}
+
+/*
+ * Frame holding page_id, for an optimistic reader that neither pins nor
+ * latches it, without taking any lock. The frame may get another page at any
+ * time, write latched meanwhile: the reader reads the version of the frame
+ * (Page::ReadVersion), checks that it still holds page_id, reads the content
+ * and validates the version (Page::ValidateVersion) before trusting anything
+ * it read.
+ * @return: nullptr if the page is not resident or still being read
+ */
+Page *BufferPoolManager::PeekPage(page_id_t page_id) {
+  assert(page_id != INVALID_PAGE_ID);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  Page *page = nullptr;
+
+  if (!instance.page_table_->Find(page_id, page) || page->io_in_flight_) {
+    return nullptr;
+  }
   return page;
 }
 
@@ -94,20 +251,21 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
   assert(page_id != INVALID_PAGE_ID);
-  std::lock_guard<std::mutex> latch(latch_);
-  
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::lock_guard<std::mutex> latch(instance.latch_);
+
   Page *page = nullptr;
-  bool ok = page_table_->Find(page_id, page); 
-    
+  bool ok = instance.page_table_->Find(page_id, page);
+
   if (ok && page->pin_count_ > 0) {
     if (is_dirty) {
 	  page->is_dirty_ = true;
     }
     if (--page->pin_count_ == 0) {
-      replacer_->Insert(page);
-    } 
+      instance.replacer_->Insert(page);
+    }
     return true;
-  } 
+  }
   return false;
 }
 
@@ -119,12 +277,29 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
   assert(page_id != INVALID_PAGE_ID);
-  std::lock_guard<std::mutex> latch(latch_);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::unique_lock<std::mutex> latch(instance.latch_);
   Page *page = nullptr;
-  bool ok = page_table_->Find(page_id, page);
+  bool ok = instance.page_table_->Find(page_id, page);
 
   if (ok) {
+    // pin the page so it stays resident while the latch is released
+    if (page->pin_count_++ == 0)
+      instance.replacer_->Erase(page);
+    page->is_dirty_ = false;
+    latch.unlock();
+
+    page->RLatch();
+    if (log_manager_ != nullptr && ENABLE_LOGGING &&
+	page->GetLSN() > log_manager_->GetPersistentLSN()) {
+      log_manager_->Flush();
+    }
     disk_manager_->WritePage(page->page_id_, page->data_);
+    page->RUnlatch();
+
+    latch.lock();
+    if (--page->pin_count_ == 0)
+      instance.replacer_->Insert(page);
     return true;
   }
   return false;
@@ -136,20 +311,37 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
  * table, buffer pool manager should be reponsible for removing this entry out
  * of page table, reseting page metadata and adding back to free list. Second,
  * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+ * the page is found within page table, but pin_count != 0, return false. A
+ * page still being written back is waited for, its frame and id can't be
+ * reused before the write completes
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
   assert(page_id != INVALID_PAGE_ID);
-  std::lock_guard<std::mutex> latch(latch_);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::unique_lock<std::mutex> latch(instance.latch_);
   Page *page = nullptr;
-  bool ok = page_table_->Find(page_id, page);
+  bool ok = instance.page_table_->Find(page_id, page);
 
+  while (ok && page->pin_count_ == 0 && page->write_back_in_flight_) {
+    // the flusher writes the frame out without a pin, and releases the read
+    // latch once its write completes. The frame is pinned meanwhile so that
+    // it keeps the page
+    instance.replacer_->Erase(page);
+    page->pin_count_ = 1;
+    latch.unlock();
+    page->WLatch();
+    page->WUnlatch();
+    latch.lock();
+    if (--page->pin_count_ == 0)
+      instance.replacer_->Insert(page);
+    ok = instance.page_table_->Find(page_id, page);
+  }
   if (ok && page->pin_count_ == 0) {
-    page->is_dirty_ = false; 
+    instance.page_table_->Remove(page_id);
+    instance.replacer_->Discard(page);
+    page->is_dirty_ = false;
     page->page_id_ = INVALID_PAGE_ID;
-    page_table_->Remove(page->page_id_); 
-    free_list_->push_back(page);
-    replacer_->Erase(page);
+    instance.free_list_->push_back(page);
     disk_manager_->DeallocatePage(page_id);
     return true;
   } else if (!ok) {
@@ -160,41 +352,286 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
   return false;
 }
 
+/*
+ * Start reading page_id into the buffer pool unless it is resident, and
+ * return without waiting for it
+ */
+void BufferPoolManager::Prefetch(page_id_t page_id) {
+  PrefetchPages(std::vector<page_id_t>{page_id});
+}
+
+/*
+ * Start reading the given pages into the buffer pool and return without
+ * waiting for them: the reads of all the missing pages are submitted as one
+ * batch. Pages already resident, and pages whose instance has every frame
+ * pinned, are skipped. Until its read completes, a prefetched frame stays
+ * pinned and write latched like any frame being loaded, so a fetcher of the
+ * page waits on that frame only
+ */
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    assert(page_id != INVALID_PAGE_ID);
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::unique_lock<std::mutex> latch(instance.latch_);
+    Page *page = nullptr;
+
+    if (instance.page_table_->Find(page_id, page) ||
+        !FindVictim(instance, latch, page_id, page) ||
+        page->page_id_ == page_id) {
+      continue;
+    }
+    page->is_dirty_ = false;
+    page->pin_count_ = 1;
+    page->io_in_flight_ = true;
+    page->WLatch();
+    page->page_id_ = page_id;
+    instance.page_table_->Insert(page_id, page);
+    latch.unlock();
+
+    async_in_flight_++;
+    disk_manager_->ReadPageAsync(page_id, page->data_, [this, page, page_id]() {
+      page->io_in_flight_ = false;
+      page->WUnlatch();
+      UnpinPage(page_id, false);
+      async_in_flight_--;
+    });
+  }
+  disk_manager_->SubmitAsync();
+}
+
+/*
+ * Start writing back the given pages that are resident and dirty, as one
+ * asynchronous batch, and return without waiting for them. Like in
+ * FlushPage, each page stays pinned and read latched until its write
+ * completes
+ */
+void BufferPoolManager::WriteBackPages(const std::vector<page_id_t> &page_ids) {
+  WriteBack(page_ids, false);
+}
+
+/*
+ * Write back every page that may differ from disk, one instance at a time,
+ * and wait for them. Pinned pages are written too even if not dirty yet,
+ * their users may have modified them already. Writers keep running, a page
+ * is only read latched for its own write
+ */
+void BufferPoolManager::FlushAllPages() {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    std::vector<page_id_t> page_ids;
+    {
+      std::lock_guard<std::mutex> latch(instance.latch_);
+      for (size_t j = 0; j < instance.pool_size_; ++j) {
+	Page *page = &instance.pages_[j];
+	if (page->page_id_ != INVALID_PAGE_ID && !page->io_in_flight_ &&
+	    (page->is_dirty_ || page->pin_count_ > 0)) {
+	  page_ids.push_back(page->page_id_);
+	}
+      }
+    }
+    WriteBack(page_ids, true);
+    disk_manager_->WaitAsync();
+  }
+}
+
+/*
+ * Collect the pages that may differ from disk (dirty, or pinned and possibly
+ * being modified) with their page lsn, for checkpointing
+ */
+void BufferPoolManager::GetDirtyPages(
+    std::unordered_map<page_id_t, lsn_t> &dirty_pages) {
+  for (size_t i = 0; i < num_instances_; ++i) {
+    BufferPoolInstance &instance = instances_[i];
+    std::lock_guard<std::mutex> latch(instance.latch_);
+    for (size_t j = 0; j < instance.pool_size_; ++j) {
+      Page *page = &instance.pages_[j];
+      if (page->page_id_ != INVALID_PAGE_ID &&
+	  (page->is_dirty_ || page->pin_count_ > 0)) {
+	dirty_pages[page->page_id_] = page->GetLSN();
+      }
+    }
+  }
+}
+
+/*
+ * Implementation of WriteBackPages, pinned_too also writes back pages that
+ * are pinned but not dirty yet. A page whose log records are not persistent
+ * forces the log first (write ahead logging)
+ */
+void BufferPoolManager::WriteBack(const std::vector<page_id_t> &page_ids,
+				  bool pinned_too) {
+  for (page_id_t page_id : page_ids) {
+    assert(page_id != INVALID_PAGE_ID);
+    BufferPoolInstance &instance = GetInstance(page_id);
+    std::unique_lock<std::mutex> latch(instance.latch_);
+    Page *page = nullptr;
+
+    if (!instance.page_table_->Find(page_id, page) || page->io_in_flight_ ||
+	(!page->is_dirty_ && !(pinned_too && page->pin_count_ > 0))) {
+      continue;
+    }
+    if (page->pin_count_++ == 0)
+      instance.replacer_->Erase(page);
+    page->is_dirty_ = false;
+    latch.unlock();
+
+    if (!page->TryRLatch()) {
+      // the writer may be waiting on a page of this batch, release them first
+      disk_manager_->SubmitAsync();
+      page->RLatch();
+    }
+    if (log_manager_ != nullptr && ENABLE_LOGGING &&
+	page->GetLSN() > log_manager_->GetPersistentLSN()) {
+      log_manager_->Flush();
+    }
+    async_in_flight_++;
+    disk_manager_->WritePageAsync(page_id, page->data_, [this, page, page_id]() {
+      page->RUnlatch();
+      UnpinPage(page_id, false);
+      async_in_flight_--;
+    });
+  }
+  disk_manager_->SubmitAsync();
+}
+
+/*
+ * Start the flusher thread, which calls FlushDirtyPages on every instance
+ * each FLUSHER_INTERVAL until StopFlusherThread. high_dirty_ratio and
+ * low_dirty_ratio are the watermarks, as fractions of the pool size
+ */
+void BufferPoolManager::RunFlusherThread(double high_dirty_ratio,
+					 double low_dirty_ratio) {
+  assert(low_dirty_ratio <= high_dirty_ratio);
+  if (flusher_running_.exchange(true)) {
+    return;
+  }
+  high_dirty_ratio_ = high_dirty_ratio;
+  low_dirty_ratio_ = low_dirty_ratio;
+  flusher_thread_ = std::thread([this]() {
+    std::unique_lock<std::mutex> latch(flusher_latch_);
+    while (flusher_running_) {
+      latch.unlock();
+      for (size_t i = 0; i < num_instances_; ++i) {
+	FlushDirtyPages(instances_[i]);
+      }
+      latch.lock();
+      flusher_cv_.wait_for(latch, FLUSHER_INTERVAL,
+			   [this]() { return !flusher_running_; });
+    }
+  });
+}
+
+/*
+ * Stop and join the flusher thread, writes it started may still be in flight
+ */
+void BufferPoolManager::StopFlusherThread() {
+  {
+    std::lock_guard<std::mutex> latch(flusher_latch_);
+    if (!flusher_running_.exchange(false)) {
+      return;
+    }
+    flusher_cv_.notify_one();
+  }
+  flusher_thread_.join();
+}
+
+/*
+ * One round of the flusher on one instance: walk the evictable frames from
+ * the next victim on, and start writing back the dirty ones as one
+ * asynchronous batch. The cold end (a quarter of the frames) is always
+ * cleaned, past it only while more than low_dirty_ratio_ of the frames are
+ * dirty, and only if there were more than high_dirty_ratio_ to begin with.
+ * Frames are neither pinned nor touched in the replacer: each one is read
+ * latched and marked write_back_in_flight_ until its write completes, and
+ * FindVictim waits for that. Pages pinned, latched by a writer, or with log
+ * records not yet persistent are left alone
+ */
+void BufferPoolManager::FlushDirtyPages(BufferPoolInstance &instance) {
+  std::vector<Page *> candidates;
+  // the page id is taken under the latch, DeletePage may reset it meanwhile
+  std::vector<std::pair<page_id_t, Page *>> flushing;
+  {
+    std::lock_guard<std::mutex> latch(instance.latch_);
+    size_t dirty = 0;
+    for (size_t i = 0; i < instance.pool_size_; ++i) {
+      if (instance.pages_[i].is_dirty_) {
+	dirty++;
+      }
+    }
+    size_t cold = std::max<size_t>(1, instance.pool_size_ / 4);
+    size_t high = static_cast<size_t>(high_dirty_ratio_ * instance.pool_size_);
+    size_t low = static_cast<size_t>(low_dirty_ratio_ * instance.pool_size_);
+    bool over_high = dirty > high;
+    instance.replacer_->Peek(candidates, instance.pool_size_);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (i >= cold && (!over_high || dirty <= low)) {
+	break;
+      }
+      Page *page = candidates[i];
+      if (page->pin_count_ > 0 || !page->is_dirty_ ||
+	  page->write_back_in_flight_ || page->io_in_flight_ ||
+	  !page->TryRLatch()) {
+	continue;
+      }
+      if (log_manager_ != nullptr && ENABLE_LOGGING &&
+	  page->GetLSN() > log_manager_->GetPersistentLSN()) {
+	// write ahead logging, the log records must reach the disk first
+	page->RUnlatch();
+	continue;
+      }
+      page->is_dirty_ = false;
+      page->write_back_in_flight_ = true;
+      flushing.emplace_back(page->page_id_, page);
+      dirty--;
+    }
+  }
+
+  for (auto &entry : flushing) {
+    Page *page = entry.second;
+    async_in_flight_++;
+    disk_manager_->WritePageAsync(entry.first, page->data_, [this, page]() {
+      page->RUnlatch();
+      page->write_back_in_flight_ = false;
+      async_in_flight_--;
+    });
+  }
+  if (!flushing.empty()) {
+    disk_manager_->SubmitAsync();
+  }
+}
+
 /**
  * User should call this method if needs to create a new page. This routine
  * will call disk manager to allocate a page.
  * Buffer pool manager should be responsible to choose a victim page either
  * from free list or lru replacer(NOTE: always choose from free list first),
  * update new page's metadata, zero out memory and add corresponding entry
- * into page table. return nullptr if all the pages in pool are pinned
+ * into page table. return nullptr if all the pages in the instance owning the
+ * new page id are pinned. Objects keeping their pages together pass their
+ * extent
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  std::lock_guard<std::mutex> latch(latch_);
-  page_id = disk_manager_->AllocatePage();
+Page *BufferPoolManager::NewPage(page_id_t &page_id, Extent *extent) {
+  page_id = disk_manager_->AllocatePage(extent);
+  BufferPoolInstance &instance = GetInstance(page_id);
+  std::unique_lock<std::mutex> latch(instance.latch_);
   Page *page = nullptr;
-  
-  if (!free_list_->empty()) {
-    // find from free list
-    page = free_list_->front();
-    free_list_->pop_front();
-  } else {
-    // find from lru replacer 
-    bool ok = replacer_->Victim(page);
-    if (!ok) {
-      // all page are pinned 
-      return nullptr;
-    }
-
-    assert(page_table_->Remove(page->page_id_)); 
-    if (page->is_dirty_) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
-    } 
-  } 
-  page->is_dirty_ = true; 
+
+  if (!FindVictim(instance, latch, page_id, page)) {
+    // don't leak the page id
+    disk_manager_->DeallocatePage(page_id);
+    return nullptr;
+  }
+  // a freshly allocated page id can't be resident already
+  assert(page->page_id_ != page_id);
+  page->is_dirty_ = true;
   page->pin_count_ = 1;
-  page->page_id_ = page_id; 
-  page_table_->Insert(page_id, page); 
-  memset(page->data_, 0, PAGE_SIZE);
+  // optimistic readers of the previous page see the version change
+  page->WLatch();
+  page->page_id_ = page_id;
+  instance.page_table_->Insert(page_id, page);
+  page->ResetMemory();
+  page->WUnlatch();
   return page;
 }
 
@@ -218,4 +655,14 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {
 
     return res;
   }
+
+  int BufferPoolManager::DirtyNum() const {
+    int sum = 0;
+    for (size_t i=0; i<pool_size_; i++) {
+      if (pages_[i].is_dirty_) {
+	sum++;
+      }
+    }
+    return sum;
+  }
 } // namespace cmudb
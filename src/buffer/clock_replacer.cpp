@@ -0,0 +1,104 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+  template <typename T>
+  ClockReplacer<T>::ClockReplacer(size_t num_frames, T base)
+      : num_frames_(num_frames), base_(base), size_(0), hand_(0) {
+    frames_ = new std::atomic<uint8_t>[num_frames_];
+    for (size_t i = 0; i < num_frames_; ++i) {
+      frames_[i] = 0;
+    }
+  }
+
+  template <typename T> ClockReplacer<T>::~ClockReplacer() { delete[] frames_; }
+
+  /*
+   * Mark value as evictable and referenced
+   */
+  template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+    size_t frame_id = FrameId(value);
+    assert(frame_id < num_frames_);
+    uint8_t old = frames_[frame_id].fetch_or(IN_REPLACER | REFERENCED);
+    if (!(old & IN_REPLACER)) {
+      size_++;
+    }
+  }
+
+  /*
+   * Sweep the clock hand: a referenced frame gets its second chance (the bit
+   * is cleared), the first evictable unreferenced frame is the victim. Two
+   * full rounds clear every reference bit, so if nothing turned up after that
+   * the replacer is empty (or only raced with concurrent Erase)
+   */
+  template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+    std::lock_guard<std::mutex> latch(clock_hand_latch_);
+    for (size_t i = 0; i < 2 * num_frames_ && size_ > 0; ++i) {
+      size_t frame_id = hand_;
+      hand_ = (hand_ + 1) % num_frames_;
+
+      uint8_t state = frames_[frame_id].load();
+      if (!(state & IN_REPLACER)) {
+        continue;
+      }
+      if (state & REFERENCED) {
+        // second chance, a concurrent Insert setting the bit again is fine
+        frames_[frame_id].fetch_and(static_cast<uint8_t>(~REFERENCED));
+        continue;
+      }
+      if (frames_[frame_id].compare_exchange_strong(state, 0)) {
+        size_--;
+        value = base_ + frame_id;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*
+   * Remove value from replacer. If removal is successful, return true,
+   * otherwise return false
+   */
+  template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+    size_t frame_id = FrameId(value);
+    assert(frame_id < num_frames_);
+    uint8_t old = frames_[frame_id].exchange(0);
+    if (old & IN_REPLACER) {
+      size_--;
+      return true;
+    }
+    return false;
+  }
+
+  template <typename T> size_t ClockReplacer<T>::Size() { return size_; }
+
+  /*
+   * Collect up to max_count evictable frames in the order the hand would
+   * reach them, unreferenced frames (this sweep's victims) before referenced
+   * ones. Nothing changes, not even reference bits
+   */
+  template <typename T>
+  void ClockReplacer<T>::Peek(std::vector<T> &values, size_t max_count) {
+    std::lock_guard<std::mutex> latch(clock_hand_latch_);
+    for (uint8_t referenced : {uint8_t(0), REFERENCED}) {
+      for (size_t i = 0; i < num_frames_ && values.size() < max_count; ++i) {
+        size_t frame_id = (hand_ + i) % num_frames_;
+        uint8_t state = frames_[frame_id].load();
+        if ((state & IN_REPLACER) && (state & REFERENCED) == referenced) {
+          values.push_back(base_ + frame_id);
+        }
+      }
+    }
+  }
+
+  template class ClockReplacer<Page *>;
+// test only
+  template class ClockReplacer<int>;
+
+} // namespace cmudb
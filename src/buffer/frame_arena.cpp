@@ -0,0 +1,113 @@
+/**
+ * frame_arena.cpp
+ */
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+#if defined(__linux__) && defined(__NR_mbind) && defined(__has_include)
+#if __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#define HAVE_MBIND 1
+#endif
+#endif
+
+namespace cmudb {
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static size_t RoundUp(size_t size, size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+/*
+ * Constructor: map the arena, place it on NUMA nodes and fault it in if
+ * asked. Reserved huge pages are only tried for arenas of at least one of
+ * them
+ */
+FrameArena::FrameArena(size_t size, bool prefault, NumaPolicy numa_policy,
+                       int numa_node)
+    : data_(nullptr), size_(0), huge_pages_(false) {
+  void *data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (size >= HUGE_PAGE_SIZE) {
+    size_ = RoundUp(size, HUGE_PAGE_SIZE);
+    data = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_pages_ = data != MAP_FAILED;
+  }
+#endif
+  if (data == MAP_FAILED) {
+    size_ = RoundUp(size, sysconf(_SC_PAGESIZE));
+    data = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (size_ >= HUGE_PAGE_SIZE) {
+      // a hint only, transparent huge pages may be disabled
+      madvise(data, size_, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  data_ = static_cast<char *>(data);
+
+  // the policy applies to pages faulted in from now on
+  Place(numa_policy, numa_node);
+  if (prefault) {
+    Prefault();
+  }
+}
+
+FrameArena::~FrameArena() { munmap(data_, size_); }
+
+/*
+ * Bind the arena to numa_node, or interleave it over every node the process
+ * may use. Best effort: without NUMA support the arena stays local
+ */
+void FrameArena::Place(NumaPolicy numa_policy, int numa_node) {
+  if (numa_policy == NumaPolicy::LOCAL) {
+    return;
+  }
+#ifdef HAVE_MBIND
+  unsigned long node_mask = ~0UL;
+  int mode = MPOL_INTERLEAVE;
+  if (numa_policy == NumaPolicy::BIND) {
+    if (numa_node < 0 ||
+        numa_node >= static_cast<int>(8 * sizeof(node_mask))) {
+      LOG_DEBUG("invalid NUMA node %d, arena left local", numa_node);
+      return;
+    }
+    node_mask = 1UL << numa_node;
+    mode = MPOL_BIND;
+  }
+  // the kernel keeps the nodes of the mask the process is allowed on
+  if (syscall(__NR_mbind, data_, size_, mode, &node_mask,
+              8 * sizeof(node_mask), 0) != 0) {
+    LOG_DEBUG("mbind failed (%s), arena left local", strerror(errno));
+  }
+#else
+  (void)numa_node;
+  LOG_DEBUG("no NUMA support, arena left local");
+#endif
+}
+
+/*
+ * Touch every memory page of the arena so that it is backed right away
+ */
+void FrameArena::Prefault() {
+  size_t step = huge_pages_ ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+  for (size_t offset = 0; offset < size_; offset += step) {
+    // volatile, so the write of a zero over a zero is not optimized away
+    *static_cast<volatile char *>(data_ + offset) = 0;
+  }
+}
+
+} // namespace cmudb
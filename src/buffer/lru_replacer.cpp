@@ -59,6 +59,18 @@ namespace cmudb {
 
   template <typename T> size_t LRUReplacer<T>::Size() { return lru_list_.size(); }
 
+  /*
+   * Collect up to max_count values from the tail of LRU, without removing them
+   */
+  template <typename T>
+  void LRUReplacer<T>::Peek(std::vector<T> &values, size_t max_count) {
+    std::lock_guard<std::mutex> latch(lru_replacer_latch_);
+    for (auto itr = lru_list_.rbegin();
+         itr != lru_list_.rend() && values.size() < max_count; ++itr) {
+      values.push_back(*itr);
+    }
+  }
+
   template class LRUReplacer<Page *>;
 // test only
   template class LRUReplacer<int>;
@@ -0,0 +1,141 @@
+/**
+ * page_table.cpp
+ */
+#include <cassert>
+
+#include "buffer/page_table.h"
+
+namespace cmudb {
+
+/*
+ * Capacity is the smallest power of two holding twice num_frames, so the
+ * load factor never exceeds one half
+ */
+PageTable::PageTable(size_t num_frames) : version_(0) {
+  size_t capacity = 2;
+  int bits = 1;
+  while (capacity < 2 * num_frames) {
+    capacity <<= 1;
+    bits++;
+  }
+  assert(bits < 32);
+  mask_ = capacity - 1;
+  shift_ = 32 - bits;
+  slots_ = new Slot[capacity];
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    slots_[i].page_.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+PageTable::~PageTable() { delete[] slots_; }
+
+/*
+ * Lock free lookup. The page id of a slot is published after its frame, and
+ * re-read after the frame, so a hit never returns the frame of a slot reused
+ * meanwhile. A miss only counts if no Remove ran during the probe
+ */
+bool PageTable::Find(page_id_t page_id, Page *&page) const {
+  assert(page_id != INVALID_PAGE_ID);
+  for (;;) {
+    uint64_t version = version_.load(std::memory_order_acquire);
+    bool retry = false;
+    size_t i = Home(page_id);
+    for (size_t n = 0; n <= mask_; ++n, i = (i + 1) & mask_) {
+      page_id_t slot_id = slots_[i].page_id_.load(std::memory_order_acquire);
+      if (slot_id == INVALID_PAGE_ID) {
+        break;
+      }
+      if (slot_id == page_id) {
+        Page *slot_page = slots_[i].page_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slots_[i].page_id_.load(std::memory_order_relaxed) == page_id) {
+          page = slot_page;
+          return true;
+        }
+        // the slot got shifted or reused under us
+        retry = true;
+        break;
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!retry && (version & 1) == 0 &&
+        version_.load(std::memory_order_relaxed) == version) {
+      return false;
+    }
+  }
+}
+
+/*
+ * Map page_id to page, replacing the frame if page_id is already there
+ * NOTE: caller must serialize Insert and Remove
+ */
+void PageTable::Insert(page_id_t page_id, Page *page) {
+  assert(page_id != INVALID_PAGE_ID);
+  size_t i = Home(page_id);
+  for (size_t n = 0; n <= mask_; ++n, i = (i + 1) & mask_) {
+    page_id_t slot_id = slots_[i].page_id_.load(std::memory_order_relaxed);
+    if (slot_id == page_id) {
+      slots_[i].page_.store(page, std::memory_order_relaxed);
+      return;
+    }
+    if (slot_id == INVALID_PAGE_ID) {
+      slots_[i].page_.store(page, std::memory_order_relaxed);
+      slots_[i].page_id_.store(page_id, std::memory_order_release);
+      return;
+    }
+  }
+  // more pages than twice the frames it was sized for
+  assert(false);
+}
+
+/*
+ * Remove page_id, then walk the rest of its cluster and move back every entry
+ * whose home slot is not between the hole and itself, so that no probe
+ * sequence ever crosses an empty slot before reaching its page
+ * NOTE: caller must serialize Insert and Remove
+ */
+bool PageTable::Remove(page_id_t page_id) {
+  assert(page_id != INVALID_PAGE_ID);
+  size_t hole = Home(page_id);
+  for (size_t n = 0;; ++n, hole = (hole + 1) & mask_) {
+    page_id_t slot_id = slots_[hole].page_id_.load(std::memory_order_relaxed);
+    if (slot_id == INVALID_PAGE_ID || n > mask_) {
+      return false;
+    }
+    if (slot_id == page_id) {
+      break;
+    }
+  }
+
+  version_.fetch_add(1, std::memory_order_acq_rel);
+  size_t i = hole;
+  for (;;) {
+    i = (i + 1) & mask_;
+    page_id_t slot_id = slots_[i].page_id_.load(std::memory_order_relaxed);
+    if (slot_id == INVALID_PAGE_ID) {
+      break;
+    }
+    size_t home = Home(slot_id);
+    // entry stays if its home lies cyclically in (hole, i]
+    bool stays = hole <= i ? (hole < home && home <= i)
+                           : (hole < home || home <= i);
+    if (stays) {
+      continue;
+    }
+    // empty the hole before its frame changes, so a reader that sees the new
+    // frame re-reads an id other than the old one. The moved entry is then
+    // visible twice until the next move or the final clear
+    slots_[hole].page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slots_[hole].page_.store(slots_[i].page_.load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+    slots_[hole].page_id_.store(slot_id, std::memory_order_release);
+    hole = i;
+  }
+  slots_[hole].page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+  version_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+} // namespace cmudb
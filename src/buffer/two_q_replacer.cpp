@@ -0,0 +1,169 @@
+/**
+ * 2Q implementation
+ */
+#include <algorithm>
+
+#include "buffer/two_q_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+  // the page a value stands for
+  static inline page_id_t PageIdOf(Page *page) { return page->GetPageId(); }
+  static inline page_id_t PageIdOf(int page_id) { return page_id; }
+
+  template <typename T>
+  TwoQReplacer<T>::TwoQReplacer(size_t num_frames)
+      : kin_(std::max<size_t>(1, num_frames / 4)),
+        kout_(std::max<size_t>(1, num_frames / 2)), size_(0) {}
+
+  template <typename T> TwoQReplacer<T>::~TwoQReplacer() {}
+
+  /*
+   * Value got unpinned, which counts as one reference to its page
+   */
+  template <typename T> void TwoQReplacer<T>::Insert(const T &value) {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    page_id_t page_id = PageIdOf(value);
+    auto itr = resident_.find(page_id);
+    if (itr != resident_.end()) {
+      Entry &entry = itr->second;
+      entry.value = value;
+      if (!entry.evictable) {
+        entry.evictable = true;
+        size_++;
+      }
+      // a hit in A1in is correlated with the first one, keep its position
+      if (entry.in_am) {
+        am_.splice(am_.begin(), am_, entry.position);
+      }
+      return;
+    }
+
+    Entry entry;
+    entry.value = value;
+    entry.evictable = true;
+    auto ghost = a1out_map_.find(page_id);
+    if (ghost != a1out_map_.end()) {
+      // referenced again after leaving A1in, it belongs to the working set
+      a1out_.erase(ghost->second);
+      a1out_map_.erase(ghost);
+      entry.in_am = true;
+      am_.push_front(page_id);
+      entry.position = am_.begin();
+    } else {
+      entry.in_am = false;
+      a1in_.push_front(page_id);
+      entry.position = a1in_.begin();
+    }
+    resident_.insert({page_id, entry});
+    size_++;
+  }
+
+  /*
+   * Reclaim from A1in while it holds more than its share, otherwise from the
+   * LRU end of Am. A page evicted from A1in is remembered in A1out
+   */
+  template <typename T> bool TwoQReplacer<T>::Victim(T &value) {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    if (size_ == 0) {
+      return false;
+    }
+    if (a1in_.size() >= kin_ && VictimFrom(a1in_, value)) {
+      return true;
+    }
+    return VictimFrom(am_, value) || VictimFrom(a1in_, value);
+  }
+
+  /*
+   * Evict the oldest unpinned page of queue
+   * NOTE: caller must hold two_q_replacer_latch_
+   */
+  template <typename T>
+  bool TwoQReplacer<T>::VictimFrom(std::list<page_id_t> &queue, T &value) {
+    for (auto itr = queue.rbegin(); itr != queue.rend(); ++itr) {
+      page_id_t page_id = *itr;
+      auto entry = resident_.find(page_id);
+      if (!entry->second.evictable) {
+        continue;
+      }
+      value = entry->second.value;
+      queue.erase(std::next(itr).base());
+      if (!entry->second.in_am) {
+        a1out_.push_front(page_id);
+        a1out_map_[page_id] = a1out_.begin();
+        if (a1out_.size() > kout_) {
+          a1out_map_.erase(a1out_.back());
+          a1out_.pop_back();
+        }
+      }
+      resident_.erase(entry);
+      size_--;
+      return true;
+    }
+    return false;
+  }
+
+  /*
+   * Value got pinned, it stays in its queue but can't be a victim. Return
+   * true if it was evictable
+   */
+  template <typename T> bool TwoQReplacer<T>::Erase(const T &value) {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    auto itr = resident_.find(PageIdOf(value));
+    if (itr != resident_.end() && itr->second.evictable) {
+      itr->second.evictable = false;
+      size_--;
+      return true;
+    }
+    return false;
+  }
+
+  /*
+   * The page of value is gone (deleted), forget it without a ghost entry
+   */
+  template <typename T> void TwoQReplacer<T>::Discard(const T &value) {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    auto itr = resident_.find(PageIdOf(value));
+    if (itr == resident_.end()) {
+      return;
+    }
+    Entry &entry = itr->second;
+    (entry.in_am ? am_ : a1in_).erase(entry.position);
+    if (entry.evictable) {
+      size_--;
+    }
+    resident_.erase(itr);
+  }
+
+  template <typename T> size_t TwoQReplacer<T>::Size() {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    return size_;
+  }
+
+  /*
+   * Collect up to max_count evictable values in the order Victim would pick
+   * them: A1in first while it holds more than its share, then Am, then the
+   * rest of A1in
+   */
+  template <typename T>
+  void TwoQReplacer<T>::Peek(std::vector<T> &values, size_t max_count) {
+    std::lock_guard<std::mutex> latch(two_q_replacer_latch_);
+    bool a1in_first = a1in_.size() >= kin_;
+    for (auto *queue :
+         {a1in_first ? &a1in_ : &am_, a1in_first ? &am_ : &a1in_}) {
+      for (auto itr = queue->rbegin();
+           itr != queue->rend() && values.size() < max_count; ++itr) {
+        const Entry &entry = resident_.find(*itr)->second;
+        if (entry.evictable) {
+          values.push_back(entry.value);
+        }
+      }
+    }
+  }
+
+  template class TwoQReplacer<Page *>;
+// test only
+  template class TwoQReplacer<int>;
+
+} // namespace cmudb
@@ -2,6 +2,17 @@
 
 namespace cmudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
+  // small on purpose so that tests exercise splits and eviction, the storage
+  // engine picks its own sizes
+  int PAGE_SIZE = MIN_PAGE_SIZE;
+  size_t BUFFER_POOL_SIZE = 10;
+  NumaPolicy BUFFER_POOL_NUMA_POLICY = NumaPolicy::LOCAL;
+  int BUFFER_POOL_NUMA_NODE = 0;
+  bool BUFFER_POOL_PREFAULT = false;
+  int OPTIMISTIC_LOOKUP_ATTEMPTS = 8;
   std::chrono::duration<long long int> LOG_TIMEOUT =
     std::chrono::seconds(1);
+  // how often the buffer pool flusher looks for dirty pages
+  std::chrono::milliseconds FLUSHER_INTERVAL =
+    std::chrono::milliseconds(10);
 }
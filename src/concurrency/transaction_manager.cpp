@@ -10,6 +10,10 @@ namespace cmudb {
 
 Transaction *TransactionManager::Begin() {
   Transaction *txn = new Transaction(next_txn_id_++);
+  {
+    std::lock_guard<std::mutex> latch(active_txns_latch_);
+    active_txns_[txn->GetTransactionId()] = txn;
+  }
 
   if (ENABLE_LOGGING) {
     // TODO: write log and update transaction's prev_lsn here
@@ -37,6 +41,11 @@ void TransactionManager::Commit(Transaction *txn) {
     // TODO: write log and update transaction's prev_lsn here
   }
 
+  {
+    std::lock_guard<std::mutex> latch(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
+  }
+
   // release all the lock
   std::unordered_set<RID> lock_set;
   for (auto item : *txn->GetSharedLockSet())
@@ -74,6 +83,11 @@ void TransactionManager::Abort(Transaction *txn) {
     // TODO: write log and update transaction's prev_lsn here
   }
 
+  {
+    std::lock_guard<std::mutex> latch(active_txns_latch_);
+    active_txns_.erase(txn->GetTransactionId());
+  }
+
   // release all the lock
   std::unordered_set<RID> lock_set;
   for (auto item : *txn->GetSharedLockSet())
@@ -85,4 +99,16 @@ void TransactionManager::Abort(Transaction *txn) {
     lock_manager_->Unlock(txn, locked_rid);
   }
 }
+
+/*
+ * Copy the id and last lsn of every running transaction into active_txns,
+ * for checkpointing
+ */
+void TransactionManager::GetActiveTxns(
+    std::unordered_map<txn_id_t, lsn_t> &active_txns) {
+  std::lock_guard<std::mutex> latch(active_txns_latch_);
+  for (auto &entry : active_txns_) {
+    active_txns[entry.first] = entry.second->GetPrevLSN();
+  }
+}
 } // namespace cmudb
@@ -0,0 +1,329 @@
+/**
+ * async_io.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "disk/async_io.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) &&                     \
+    defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+namespace cmudb {
+
+// worker threads of the thread pool backend
+static const size_t ASYNC_IO_WORKERS = 4;
+
+/**
+ * Constructor: set up an io_uring instance for fd, or start the thread pool
+ * if io_uring is unavailable (old kernel, forbidden by seccomp) or not wanted
+ */
+AsyncIO::AsyncIO(int fd, size_t queue_depth, bool use_io_uring)
+    : fd_(fd), in_flight_(0), queue_depth_(std::max<size_t>(queue_depth, 1)),
+      ring_fd_(-1), sq_ring_(nullptr), sq_ring_size_(0), cq_ring_(nullptr),
+      cq_ring_size_(0), sqes_(nullptr), sqes_size_(0), to_submit_(0),
+      shutdown_(false) {
+  if (use_io_uring && SetupRing(queue_depth_)) {
+    reaper_ = std::thread(&AsyncIO::ReapRing, this);
+    return;
+  }
+  for (size_t i = 0; i < std::min(ASYNC_IO_WORKERS, queue_depth_); i++) {
+    workers_.emplace_back(&AsyncIO::RunWorker, this);
+  }
+}
+
+AsyncIO::~AsyncIO() {
+  Wait();
+  std::unique_lock<std::mutex> lock(latch_);
+  shutdown_ = true;
+#ifdef HAVE_IO_URING
+  if (UsesIOUring()) {
+    // a nop carrying no request tells the reaper to stop
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+    SubmitRing(lock);
+    lock.unlock();
+    reaper_.join();
+
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+    return;
+  }
+#endif
+  queued_.notify_all();
+  lock.unlock();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void AsyncIO::PrepareRead(char *buffer, size_t size, off_t offset,
+                          Callback callback) {
+  Prepare(new Request{false, {buffer, size}, offset, std::move(callback)});
+}
+
+void AsyncIO::PrepareWrite(const char *buffer, size_t size, off_t offset,
+                           Callback callback) {
+  Prepare(new Request{true, {const_cast<char *>(buffer), size}, offset,
+                      std::move(callback)});
+}
+
+/*
+ * Queue request, first waiting for a slot if queue_depth_ requests are
+ * already in flight
+ */
+void AsyncIO::Prepare(Request *request) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (in_flight_ >= queue_depth_) {
+    // what is queued here can't complete before it is submitted
+    if (UsesIOUring()) {
+      SubmitRing(lock);
+    } else if (!prepared_.empty()) {
+      queue_.insert(queue_.end(), prepared_.begin(), prepared_.end());
+      prepared_.clear();
+      queued_.notify_all();
+    }
+    completed_.wait(lock);
+  }
+  in_flight_++;
+
+#ifdef HAVE_IO_URING
+  if (UsesIOUring()) {
+    // in_flight_ bounds the number of entries, the queue can't be full
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = request->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = fd_;
+    // the iovec must stay valid until the kernel is done with it
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov);
+    sqe->len = 1;
+    sqe->off = request->offset;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+    return;
+  }
+#endif
+  prepared_.push_back(request);
+}
+
+void AsyncIO::Submit() {
+  std::unique_lock<std::mutex> lock(latch_);
+  if (UsesIOUring()) {
+    SubmitRing(lock);
+  } else if (!prepared_.empty()) {
+    queue_.insert(queue_.end(), prepared_.begin(), prepared_.end());
+    prepared_.clear();
+    queued_.notify_all();
+  }
+}
+
+void AsyncIO::Wait() {
+  Submit();
+  std::unique_lock<std::mutex> lock(latch_);
+  while (in_flight_ > 0) {
+    completed_.wait(lock);
+  }
+}
+
+/*
+ * Run the callback of a finished request and release its slot
+ */
+void AsyncIO::Complete(Request *request, ssize_t result) {
+  request->callback(result);
+  delete request;
+  std::lock_guard<std::mutex> guard(latch_);
+  in_flight_--;
+  completed_.notify_all();
+}
+
+/*****************************************************************************
+ * IO_URING BACKEND
+ *****************************************************************************/
+/*
+ * Create the ring and map its submission queue, completion queue and
+ * submission entries
+ * @return: false if the kernel doesn't let us use io_uring
+ */
+bool AsyncIO::SetupRing(size_t queue_depth) {
+#ifdef HAVE_IO_URING
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup,
+                                         static_cast<unsigned>(queue_depth),
+                                         &params));
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring unavailable (%s), using worker threads",
+              strerror(errno));
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    close(ring_fd);
+    return false;
+  }
+  cq_ring_ = sq_ring_;
+  if (!single_mmap) {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+      close(ring_fd);
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    if (!single_mmap) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd);
+    return false;
+  }
+
+  char *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  char *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  // never more requests in flight than submission entries, the completion
+  // queue is at least as large
+  queue_depth_ = std::min<size_t>(queue_depth_, params.sq_entries);
+  ring_fd_ = ring_fd;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Pass every prepared entry to the kernel with a single system call
+ * NOTE: caller must hold latch_ through "lock"
+ */
+void AsyncIO::SubmitRing(std::unique_lock<std::mutex> &lock) {
+#ifdef HAVE_IO_URING
+  while (to_submit_ > 0) {
+    int submitted = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 0, 0, nullptr, 0));
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        // out of kernel resources for now, let completions drain
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+        continue;
+      }
+      throw Exception(std::string("io_uring_enter failed: ") +
+                      strerror(errno));
+    }
+    to_submit_ -= submitted;
+  }
+#endif
+}
+
+/*
+ * Reaper thread: sleep until completions arrive and run their callbacks,
+ * until the nop sent by the destructor shows up
+ */
+void AsyncIO::ReapRing() {
+#ifdef HAVE_IO_URING
+  io_uring_cqe *cqes = static_cast<io_uring_cqe *>(cqes_);
+  for (;;) {
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                                       IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed while waiting: %s", strerror(errno));
+    }
+
+    bool stop = false;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = &cqes[head & *cq_mask_];
+      Request *request = reinterpret_cast<Request *>(cqe->user_data);
+      ssize_t result = cqe->res;
+      // free the entry before running the callback
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      if (request == nullptr) {
+        stop = true;
+      } else {
+        Complete(request, result);
+      }
+    }
+    if (stop) {
+      return;
+    }
+  }
+#endif
+}
+
+/*****************************************************************************
+ * THREAD POOL BACKEND
+ *****************************************************************************/
+void AsyncIO::RunWorker() {
+  std::unique_lock<std::mutex> lock(latch_);
+  for (;;) {
+    while (queue_.empty() && !shutdown_) {
+      queued_.wait(lock);
+    }
+    if (queue_.empty()) {
+      return;
+    }
+    Request *request = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+
+    ssize_t result;
+    do {
+      result = request->is_write
+                   ? pwritev(fd_, &request->iov, 1, request->offset)
+                   : preadv(fd_, &request->iov, 1, request->offset);
+    } while (result == -1 && errno == EINTR);
+    Complete(request, result == -1 ? -errno : result);
+    lock.lock();
+  }
+}
+
+} // namespace cmudb
@@ -1,11 +1,18 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
 #include "disk/disk_manager.h"
@@ -14,12 +21,54 @@ namespace cmudb {
 
 static char *buffer_used = nullptr;
 
+// O_DIRECT needs buffer, offset and length aligned to the logical block size
+static const size_t DIRECT_IO_ALIGNMENT = 512;
+
+// first bytes of a free space map file, the bitmap follows
+static const uint32_t FSM_MAGIC = 0x4d534643;
+static const size_t FSM_HEADER_SIZE = 4;
+static_assert(EXTENT_SIZE % 8 == 0, "extents cover whole bytes of the map");
+
+/**
+ * Page sized buffer aligned for O_DIRECT, release it with free()
+ */
+static char *AllocateAlignedPage() {
+  void *ptr = nullptr;
+  if (posix_memalign(&ptr, DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0) {
+    throw std::bad_alloc();
+  }
+  return static_cast<char *>(ptr);
+}
+
+/**
+ * Aligned page buffer, one per thread and kept for the lifetime of the thread
+ * (or until the page size grows)
+ */
+static char *AlignedPageBuffer() {
+  static thread_local std::unique_ptr<char, decltype(&free)> buffer(
+      nullptr, &free);
+  static thread_local int buffer_size = 0;
+  if (buffer == nullptr || buffer_size < PAGE_SIZE) {
+    buffer.reset(AllocateAlignedPage());
+    buffer_size = PAGE_SIZE;
+  }
+  return buffer.get();
+}
+
+static bool IsAligned(const char *page_data) {
+  return reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input direct_io: bypass the OS page cache for page I/O, silently ignored
+ * where the file system doesn't support O_DIRECT
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : db_fd_(-1), direct_io_(false), db_file_size_(0), async_io_(nullptr),
+      file_name_(db_file), fsm_fd_(-1), free_hint_(0),
+      next_page_id_(0), num_flushes_(0), flush_log_(false),
       flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
@@ -42,21 +91,35 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // open or create the db file
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ != -1;
   }
+  if (db_fd_ == -1) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ == -1) {
+    LOG_DEBUG("can't open db file %s", db_file.c_str());
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = stat_buf.st_size;
+  }
+  async_io_ = new AsyncIO(db_fd_);
+  OpenFreeSpaceMap(file_name_.substr(0, n) + ".fsm");
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  // outstanding asynchronous requests still use the file
+  delete async_io_;
+  if (db_fd_ != -1) {
+    close(db_fd_);
+  }
+  if (fsm_fd_ != -1) {
+    close(fsm_fd_);
+  }
   log_io_.close();
 }
 
@@ -64,39 +127,154 @@ DiskManager::~DiskManager() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  const char *buffer = page_data;
+  if (direct_io_ && !IsAligned(page_data)) {
+    char *aligned = AlignedPageBuffer();
+    memcpy(aligned, page_data, PAGE_SIZE);
+    buffer = aligned;
+  }
+
+  ssize_t write_count = pwrite(db_fd_, buffer, PAGE_SIZE, offset);
+  if (write_count == -1 && errno == EINVAL && DirectIOFallback()) {
+    write_count = pwrite(db_fd_, page_data, PAGE_SIZE, offset);
+  }
   // check for I/O error
-  if (db_io_.bad()) {
+  if (write_count != PAGE_SIZE) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+
+  GrowFileSize(offset + PAGE_SIZE);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > db_file_size_) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    return;
+  }
+
+  char *buffer = page_data;
+  if (direct_io_ && !IsAligned(page_data)) {
+    buffer = AlignedPageBuffer();
+  }
+  ssize_t read_count = pread(db_fd_, buffer, PAGE_SIZE, offset);
+  if (read_count == -1 && errno == EINVAL && DirectIOFallback()) {
+    buffer = page_data;
+    read_count = pread(db_fd_, buffer, PAGE_SIZE, offset);
+  }
+  if (read_count == -1) {
+    LOG_DEBUG("I/O error while reading");
+    read_count = 0;
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, read_count);
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Queue a write of the specified page, callback runs once it is on disk (or
+ * failed). The write starts at the latest on the next SubmitAsync
+ */
+void DiskManager::WritePageAsync(page_id_t page_id, const char *page_data,
+                                 std::function<void()> callback) {
+  if (async_io_ == nullptr) {
+    WritePage(page_id, page_data);
+    callback();
+    return;
+  }
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  char *aligned = nullptr;
+  if (direct_io_ && !IsAligned(page_data)) {
+    aligned = AllocateAlignedPage();
+    memcpy(aligned, page_data, PAGE_SIZE);
+  }
+
+  async_io_->PrepareWrite(
+      aligned != nullptr ? aligned : page_data, PAGE_SIZE, offset,
+      [this, page_id, page_data, offset, aligned, callback](ssize_t result) {
+        free(aligned);
+        if (result == -EINVAL && DirectIOFallback()) {
+          WritePage(page_id, page_data);
+        } else if (result != PAGE_SIZE) {
+          LOG_DEBUG("I/O error while writing");
+        } else {
+          GrowFileSize(offset + PAGE_SIZE);
+        }
+        callback();
+      });
+}
+
+/**
+ * Queue a read of the specified page into the given memory area, callback
+ * runs once the content is there. The read starts at the latest on the next
+ * SubmitAsync
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data,
+                                std::function<void()> callback) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  if (async_io_ == nullptr || offset > db_file_size_) {
+    ReadPage(page_id, page_data);
+    callback();
+    return;
+  }
+  char *aligned = nullptr;
+  if (direct_io_ && !IsAligned(page_data)) {
+    aligned = AllocateAlignedPage();
+  }
+
+  async_io_->PrepareRead(
+      aligned != nullptr ? aligned : page_data, PAGE_SIZE, offset,
+      [this, page_id, page_data, aligned, callback](ssize_t result) {
+        if (result == -EINVAL && DirectIOFallback()) {
+          free(aligned);
+          ReadPage(page_id, page_data);
+          callback();
+          return;
+        }
+        if (result < 0) {
+          LOG_DEBUG("I/O error while reading");
+          result = 0;
+        }
+        if (aligned != nullptr) {
+          memcpy(page_data, aligned, result);
+          free(aligned);
+        }
+        // if file ends before reading PAGE_SIZE
+        if (result < PAGE_SIZE) {
+          memset(page_data + result, 0, PAGE_SIZE - result);
+        }
+        callback();
+      });
+}
+
+/**
+ * Hand every queued asynchronous page request to the disk in one batch
+ */
+void DiskManager::SubmitAsync() {
+  if (async_io_ != nullptr) {
+    async_io_->Submit();
+  }
+}
+
+/**
+ * Wait until every queued asynchronous page request has completed
+ */
+void DiskManager::WaitAsync() {
+  if (async_io_ != nullptr) {
+    async_io_->Wait();
   }
 }
 
@@ -156,18 +334,59 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
   return true;
 }
 
+/**
+ * Returns the size of the log file, where the next WriteLog appends
+ */
+int DiskManager::GetLogSize() { return std::max(GetFileSize(log_name_), 0); }
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Without an extent the lowest free page id is reused, the file only grows
+ * past the high-water mark when there is none. With one, the next page id of
+ * the extent is taken. The map reaches the disk before the page id is handed
+ * out
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(Extent *extent) {
+  std::lock_guard<std::mutex> guard(fsm_latch_);
+  page_id_t page_id;
+  if (extent == nullptr) {
+    page_id = FindFreePage();
+  } else {
+    if (extent->next_page_id_ == extent->end_page_id_) {
+      ReserveExtent(extent);
+    }
+    page_id = extent->next_page_id_++;
+    reserved_[page_id / 8] &= ~(1 << (page_id % 8));
+  }
+  free_space_map_[page_id / 8] |= 1 << (page_id % 8);
+  WriteFreeSpaceMap(page_id / 8, 1);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * The page id is free for the next AllocatePage, whatever the page holds on
+ * disk is garbage from now on
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(fsm_latch_);
+  if (page_id < 0 || page_id >= next_page_id_) {
+    return;
+  }
+  uint8_t &bits = free_space_map_[page_id / 8];
+  if ((bits & (1 << (page_id % 8))) == 0) {
+    return;
+  }
+  bits &= ~(1 << (page_id % 8));
+  WriteFreeSpaceMap(page_id / 8, 1);
+  free_hint_ = std::min(free_hint_, page_id);
+  LowerHighWaterMark();
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(fsm_latch_);
+  return page_id >= 0 && page_id < next_page_id_ &&
+         (free_space_map_[page_id / 8] & (1 << (page_id % 8))) != 0;
 }
 
 /**
@@ -180,6 +399,168 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Returns true if page I/O bypasses the OS page cache
+ */
+bool DiskManager::IsDirectIO() const { return direct_io_; }
+
+/**
+ * Private helper function, called when direct I/O was rejected (typically
+ * because the device block size is larger than the page): turn O_DIRECT off
+ * and keep going with buffered I/O
+ * @return: false if direct I/O wasn't in use, the error is a genuine one
+ */
+bool DiskManager::DirectIOFallback() {
+  if (!direct_io_.exchange(false)) {
+    // another thread may have just turned it off
+    return (fcntl(db_fd_, F_GETFL) & O_DIRECT) == 0;
+  }
+  LOG_DEBUG("direct I/O rejected, falling back to buffered I/O");
+  int flags = fcntl(db_fd_, F_GETFL);
+  return flags != -1 && fcntl(db_fd_, F_SETFL, flags & ~O_DIRECT) != -1;
+}
+
+/**
+ * Private helper function to grow the cached db file size to at least end,
+ * writers may race past each other
+ */
+void DiskManager::GrowFileSize(int64_t end) {
+  int64_t size = db_file_size_.load();
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+/**
+ * Private helper function to take the lowest page id neither allocated nor
+ * reserved, growing the map past the high-water mark if there is none
+ * NOTE: caller must hold fsm_latch_
+ */
+page_id_t DiskManager::FindFreePage() {
+  page_id_t page_id = free_hint_;
+  size_t byte = page_id / 8;
+  // skip the full bytes
+  while (page_id < next_page_id_ &&
+         (free_space_map_[byte] | reserved_[byte]) == 0xff) {
+    byte++;
+    page_id = static_cast<page_id_t>(byte * 8);
+  }
+  while (page_id < next_page_id_ && IsTaken(page_id)) {
+    page_id++;
+  }
+  if (page_id >= next_page_id_) {
+    page_id = next_page_id_++;
+    free_space_map_.resize((next_page_id_ + 7) / 8, 0);
+    reserved_.resize(free_space_map_.size(), 0);
+  }
+  free_hint_ = page_id + 1;
+  return page_id;
+}
+
+/**
+ * Private helper function to reserve EXTENT_SIZE contiguous page ids for
+ * extent: the first free run starting on a byte of the map, or the ones from
+ * the high-water mark on
+ * NOTE: caller must hold fsm_latch_
+ */
+void DiskManager::ReserveExtent(Extent *extent) {
+  const size_t run_bytes = EXTENT_SIZE / 8;
+  page_id_t first = next_page_id_;
+  size_t run = 0;
+  for (size_t byte = free_hint_ / 8;
+       byte < static_cast<size_t>(next_page_id_ + 7) / 8; byte++) {
+    run = (free_space_map_[byte] | reserved_[byte]) == 0 ? run + 1 : 0;
+    if (run == run_bytes) {
+      first = static_cast<page_id_t>((byte + 1 - run_bytes) * 8);
+      break;
+    }
+  }
+  page_id_t end = first + EXTENT_SIZE;
+  if (end > next_page_id_) {
+    next_page_id_ = end;
+    free_space_map_.resize((next_page_id_ + 7) / 8, 0);
+    reserved_.resize(free_space_map_.size(), 0);
+  }
+  for (page_id_t page_id = first; page_id < end; page_id++) {
+    reserved_[page_id / 8] |= 1 << (page_id % 8);
+  }
+  extent->next_page_id_ = first;
+  extent->end_page_id_ = end;
+}
+
+/**
+ * Private helper function to lower the high-water mark past the free pages
+ * at the end
+ * NOTE: caller must hold fsm_latch_, or be the constructor
+ */
+void DiskManager::LowerHighWaterMark() {
+  while (next_page_id_ > 0 && !IsTaken(next_page_id_ - 1)) {
+    next_page_id_--;
+  }
+}
+
+/**
+ * Private helper function to open or create the free space map, and restore
+ * the high-water mark from it. An empty database starts with an empty map,
+ * one without a valid map (created before the map existed, or whose map was
+ * lost) has every page up to its end taken as allocated
+ */
+void DiskManager::OpenFreeSpaceMap(const std::string &fsm_file) {
+  fsm_fd_ = open(fsm_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fsm_fd_ == -1) {
+    LOG_DEBUG("can't open free space map %s", fsm_file.c_str());
+  }
+  uint32_t magic = 0;
+  if (db_file_size_ > 0 && fsm_fd_ != -1 &&
+      pread(fsm_fd_, &magic, FSM_HEADER_SIZE, 0) ==
+          static_cast<ssize_t>(FSM_HEADER_SIZE) &&
+      magic == FSM_MAGIC) {
+    struct stat stat_buf;
+    if (fstat(fsm_fd_, &stat_buf) == 0 &&
+        stat_buf.st_size > static_cast<off_t>(FSM_HEADER_SIZE)) {
+      free_space_map_.resize(stat_buf.st_size - FSM_HEADER_SIZE, 0);
+      ssize_t read_count = pread(fsm_fd_, free_space_map_.data(),
+                                 free_space_map_.size(), FSM_HEADER_SIZE);
+      free_space_map_.resize(std::max<ssize_t>(read_count, 0));
+    }
+    reserved_.assign(free_space_map_.size(), 0);
+    next_page_id_ = static_cast<page_id_t>(free_space_map_.size() * 8);
+    LowerHighWaterMark();
+    return;
+  }
+
+  next_page_id_ =
+      static_cast<page_id_t>((db_file_size_ + PAGE_SIZE - 1) / PAGE_SIZE);
+  free_space_map_.assign((next_page_id_ + 7) / 8, 0);
+  reserved_.assign(free_space_map_.size(), 0);
+  for (page_id_t page_id = 0; page_id < next_page_id_; page_id++) {
+    free_space_map_[page_id / 8] |= 1 << (page_id % 8);
+  }
+  free_hint_ = next_page_id_;
+  if (fsm_fd_ != -1) {
+    magic = FSM_MAGIC;
+    if (ftruncate(fsm_fd_, 0) != 0 ||
+        pwrite(fsm_fd_, &magic, FSM_HEADER_SIZE, 0) !=
+            static_cast<ssize_t>(FSM_HEADER_SIZE)) {
+      LOG_DEBUG("I/O error while writing free space map");
+    }
+    WriteFreeSpaceMap(0, free_space_map_.size());
+  }
+}
+
+/**
+ * Private helper function to write size bytes of the map from offset on
+ * NOTE: caller must hold fsm_latch_, or be the constructor
+ */
+void DiskManager::WriteFreeSpaceMap(size_t offset, size_t size) {
+  if (fsm_fd_ == -1 || size == 0) {
+    return;
+  }
+  if (pwrite(fsm_fd_, free_space_map_.data() + offset, size,
+             FSM_HEADER_SIZE + offset) != static_cast<ssize_t>(size)) {
+    LOG_DEBUG("I/O error while writing free space map");
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
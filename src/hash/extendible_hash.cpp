@@ -23,8 +23,10 @@ namespace cmudb {
    */
   template <typename K, typename V>
   size_t ExtendibleHash<K, V>::HashKey(const K &key) {
-    std::lock_guard<std::mutex> latch(global_table_lock_);
-    return std::hash<K>{}(key) % (1 << global_depth_);
+    directory_latch_.RLock();
+    size_t bucket_id = std::hash<K>{}(key) % (1 << global_depth_);
+    directory_latch_.RUnlock();
+    return bucket_id;
   }
 
   /*
@@ -33,9 +35,10 @@ namespace cmudb {
    */
   template <typename K, typename V>
   int ExtendibleHash<K, V>::GetGlobalDepth() const {
-    // for RAII style mutex
-    std::lock_guard<std::mutex> latch(global_table_lock_);
-    return global_depth_;
+    directory_latch_.RLock();
+    int global_depth = global_depth_;
+    directory_latch_.RUnlock();
+    return global_depth;
   }
   
   /*
@@ -44,14 +47,20 @@ namespace cmudb {
    */
   template <typename K, typename V>
   int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-    assert(bucket_id < (1 << global_depth_));
     assert(bucket_id >= 0);
   
-    std::lock_guard<std::mutex> latch(global_table_lock_); 
-    std::shared_ptr<Bucket> bucket = bucket_address_table_[bucket_id];
+    directory_latch_.RLock();
+    assert(bucket_id < (1 << global_depth_));
+    std::shared_ptr<Bucket> bucket =
+      std::atomic_load(&bucket_address_table_[bucket_id]);
     assert(bucket != nullptr);
-  
-    return bucket->local_depth_;
+    int local_depth;
+    {
+      std::lock_guard<std::mutex> latch(bucket->latch_);
+      local_depth = bucket->local_depth_;
+    }
+    directory_latch_.RUnlock();
+    return local_depth;
   }
   
   /*
@@ -59,8 +68,31 @@ namespace cmudb {
    */
   template <typename K, typename V>
   int ExtendibleHash<K, V>::GetNumBuckets() const {
-    std::lock_guard<std::mutex> latch(global_table_lock_);
-    return num_buckets_;
+    directory_latch_.RLock();
+    int num_buckets = num_buckets_;
+    directory_latch_.RUnlock();
+    return num_buckets;
+  }
+
+  /*
+   * latch the bucket covering hash. A split may redirect its slot between
+   * the lookup and the latch, so check the slot again once latched
+   * NOTE: caller must hold directory_latch_ in shared mode
+   */
+  template <typename K, typename V>
+  std::shared_ptr<typename ExtendibleHash<K, V>::Bucket>
+  ExtendibleHash<K, V>::LockBucket(size_t hash) {
+    size_t bucket_id = hash % (1 << global_depth_);
+    while (true) {
+      std::shared_ptr<Bucket> bucket =
+	std::atomic_load(&bucket_address_table_[bucket_id]);
+      assert(bucket != nullptr);
+      bucket->latch_.lock();
+      if (std::atomic_load(&bucket_address_table_[bucket_id]) == bucket) {
+	return bucket;
+      }
+      bucket->latch_.unlock();
+    }
   }
 
   /*
@@ -68,11 +100,8 @@ namespace cmudb {
    */
   template <typename K, typename V>
   bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-    std::lock_guard<std::mutex> latch(global_table_lock_);
-    size_t bucket_id = std::hash<K>{}(key) % (1 << global_depth_);
-  
-    std::shared_ptr<Bucket> bucket = bucket_address_table_[bucket_id];
-    assert(bucket != nullptr);
+    directory_latch_.RLock();
+    std::shared_ptr<Bucket> bucket = LockBucket(std::hash<K>{}(key));
   
     auto it = std::find_if(bucket->kv_records_.begin(),
 			   bucket->kv_records_.end(),
@@ -80,26 +109,24 @@ namespace cmudb {
 			     return p.first == key;
 			   });
 
-    if (it != bucket->kv_records_.end()) {
+    bool found = it != bucket->kv_records_.end();
+    if (found) {
       value = it->second;
-      return true;
-    } else {
-      return false;
     }
+    bucket->latch_.unlock();
+    directory_latch_.RUnlock();
+    return found;
   }
   
   /*
    * delete <key,value> entry in hash table
-   * Shrink & Combination is not required for this project
+   * A bucket left (nearly) empty is merged with its buddy and the directory
+   * halved when possible, under the exclusive directory latch
    */
   template <typename K, typename V>
   bool ExtendibleHash<K, V>::Remove(const K &key) {
-    std::lock_guard<std::mutex> latch(global_table_lock_);
-
-    size_t bucket_id = std::hash<K>{}(key) % (1 << global_depth_);
-  
-    auto bucket = bucket_address_table_[bucket_id];
-    assert(bucket != nullptr);
+    directory_latch_.RLock();
+    std::shared_ptr<Bucket> bucket = LockBucket(std::hash<K>{}(key));
 
     auto origin_iterator = bucket->kv_records_.end();
     auto changed_iterator = remove_if(bucket->kv_records_.begin(),
@@ -107,28 +134,36 @@ namespace cmudb {
 				      [&](const std::pair<K, V>& record) {
 					return record.first == key;
 				      });
-    if (origin_iterator != changed_iterator) {
+    bool removed = origin_iterator != changed_iterator;
+    if (removed) {
       bucket->kv_records_.pop_back();
-      return true;
     }
-    return false;
+    bool underfull = removed && bucket->local_depth_ > 0 &&
+      bucket->kv_records_.size() <= size_ / 4;
+    bucket->latch_.unlock();
+    directory_latch_.RUnlock();
+
+    if (underfull) {
+      directory_latch_.WLock();
+      MergeBucket(std::hash<K>{}(key));
+      ShrinkDirectory();
+      directory_latch_.WUnlock();
+    }
+    return removed;
   }
 
   /*
-   * inserpppt <key,value> entry in hash table
-   * Split & Redistribute bucket when there is overflow and if necessary increase
-   * global depth
+   * insert <key,value> entry in hash table
+   * Split & Redistribute bucket when there is overflow. A full bucket as deep
+   * as the directory needs the directory doubled first, which is done under
+   * the exclusive directory latch before retrying
    */
   template <typename K, typename V>
   void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-    std::lock_guard<std::mutex> latch(global_table_lock_); 
-    
-    std::hash<K> hasher{};
+    size_t hash = std::hash<K>{}(key);
     while (true) {
-      size_t bucket_id = hasher(key) % (1 << global_depth_);
-  
-      auto bucket = bucket_address_table_[bucket_id];
-      assert(bucket != nullptr);
+      directory_latch_.RLock();
+      std::shared_ptr<Bucket> bucket = LockBucket(hash);
 
       auto it = std::find_if(bucket->kv_records_.begin(),
 			     bucket->kv_records_.end(),
@@ -136,70 +171,141 @@ namespace cmudb {
 			       return p.first == key;
 			     });
 
+      bool done = true;
+      bool need_double = false;
+      int local_depth = bucket->local_depth_;
       if (it != bucket->kv_records_.end()) {
 	// overwrite when already exits
 	it->second = value;
-	return;
-      }
-  
-      if (bucket->kv_records_.size() < size_) {
+      } else if (bucket->kv_records_.size() < size_) {
 	// push into bucket when not full
 	bucket->kv_records_.push_back(std::make_pair(key, value));
+      } else if (global_depth_ > local_depth) {
+	// split the bucket, then retry as its records may all go one way
+	SplitBucket(bucket, hash);
+	done = false;
+      } else {
+	done = false;
+	need_double = true;
+      }
+      bucket->latch_.unlock();
+      directory_latch_.RUnlock();
+      if (done) {
 	return;
       }
 
-      if (global_depth_ > bucket->local_depth_) {
-	// split the bucket pointer 
-	bucket->local_depth_ += 1;
-	auto new_bucket = std::make_shared<Bucket>(bucket->local_depth_);
-	auto records = std::move(bucket->kv_records_); 
-	assert(bucket->kv_records_.size() == 0);
-	records.push_back(std::make_pair(key, value));
-	for (const auto & record: records) {
-	  if (hasher(record.first) & (1 << (bucket->local_depth_-1))) {
-	    new_bucket->kv_records_.push_back(std::move(record));
-	  } else {
-	    bucket->kv_records_.push_back(std::move(record));
-	  }
+      if (need_double) {
+	directory_latch_.WLock();
+	// someone else may have doubled it meanwhile
+	if (global_depth_ == local_depth) {
+	  DoubleDirectory();
 	}
-      
-	int local_id = bucket_id % (1 << (bucket->local_depth_-1));
-	// TODO:
-	//   can we do better?
-	for (int i=0; i<(1<<global_depth_); i++) {
-	  if ((i & ((1 << (bucket->local_depth_-1))-1)) == local_id) {
-	    if (i & (1 << (bucket->local_depth_-1))) {
-	      bucket_address_table_[i] = new_bucket;
-	    } else {
-	      bucket_address_table_[i] = bucket;
-	    }
-	  }
-	}
-	return ;
+	directory_latch_.WUnlock();
       }
+    }
+  }
 
-      // expand the global table 
-      num_buckets_ *= 2;
-      bucket_address_table_.resize(num_buckets_);
-      global_depth_++;
-      for (int i = num_buckets_/2; i < num_buckets_; ++i) {
-		if (i != num_buckets_ / 2 + static_cast<int>(bucket_id))
-		  bucket_address_table_[i] = bucket_address_table_[i - num_buckets_ / 2];
-	else {
-	  bucket->local_depth_++;
-	  bucket_address_table_[i] = std::make_shared<Bucket>(bucket->local_depth_);
-	  auto records = std::move(bucket->kv_records_); 
-	  assert(bucket->kv_records_.size() == 0);
-          
-	  for (const auto & record: records) {
-	    if (hasher(record.first) & (1 << (bucket->local_depth_-1))) {
-	      bucket_address_table_[i]->kv_records_.push_back(std::move(record));
-	    } else {
-	      bucket->kv_records_.push_back(std::move(record));
-	    }
-	  }
+  /*
+   * split bucket in two by the next bit of the hash, and redirect the half of
+   * its directory slots having that bit set to the new bucket
+   * NOTE: caller must hold directory_latch_ in shared mode and the latch of
+   * bucket
+   */
+  template <typename K, typename V>
+  void ExtendibleHash<K, V>::SplitBucket(const std::shared_ptr<Bucket> &bucket,
+					 size_t hash) {
+    std::hash<K> hasher{};
+    size_t high_bit = 1 << bucket->local_depth_;
+    bucket->local_depth_ += 1;
+    auto new_bucket = std::make_shared<Bucket>(bucket->local_depth_);
+    auto records = std::move(bucket->kv_records_); 
+    bucket->kv_records_.clear();
+    for (auto &record: records) {
+      if (hasher(record.first) & high_bit) {
+	new_bucket->kv_records_.push_back(std::move(record));
+      } else {
+	bucket->kv_records_.push_back(std::move(record));
+      }
+    }
+
+    // slots sharing the low bits of bucket, with high_bit set
+    size_t first = (hash & (high_bit - 1)) | high_bit;
+    for (size_t i = first; i < static_cast<size_t>(num_buckets_);
+	 i += high_bit << 1) {
+      std::atomic_store(&bucket_address_table_[i], new_bucket);
+    }
+  }
+
+  /*
+   * double the directory, every new slot points to the bucket of its twin
+   * NOTE: caller must hold directory_latch_ exclusively
+   */
+  template <typename K, typename V>
+  void ExtendibleHash<K, V>::DoubleDirectory() {
+    bucket_address_table_.resize(num_buckets_ * 2);
+    for (int i = 0; i < num_buckets_; ++i) {
+      bucket_address_table_[num_buckets_ + i] = bucket_address_table_[i];
+    }
+    num_buckets_ *= 2;
+    global_depth_++;
+  }
+
+  /*
+   * merge the bucket covering hash with its buddy (the bucket differing in
+   * the highest bit of its depth) while both have the same depth and their
+   * records fit in half a bucket. The half bucket margin keeps a steady
+   * insert/delete churn from splitting and merging the same pair over and
+   * over
+   * NOTE: caller must hold directory_latch_ exclusively
+   */
+  template <typename K, typename V>
+  void ExtendibleHash<K, V>::MergeBucket(size_t hash) {
+    while (true) {
+      size_t bucket_id = hash % (1 << global_depth_);
+      std::shared_ptr<Bucket> bucket = bucket_address_table_[bucket_id];
+      int local_depth = bucket->local_depth_;
+      if (local_depth == 0) {
+	return;
+      }
+      size_t high_bit = 1 << (local_depth - 1);
+      std::shared_ptr<Bucket> buddy =
+	bucket_address_table_[bucket_id ^ high_bit];
+      if (buddy->local_depth_ != local_depth ||
+	  bucket->kv_records_.size() + buddy->kv_records_.size() > size_ / 2) {
+	return;
+      }
+
+      // keep the bucket without high_bit, and point every slot of both to it
+      std::shared_ptr<Bucket> low = (bucket_id & high_bit) ? buddy : bucket;
+      std::shared_ptr<Bucket> high = (bucket_id & high_bit) ? bucket : buddy;
+      for (auto &record: high->kv_records_) {
+	low->kv_records_.push_back(std::move(record));
+      }
+      low->local_depth_ -= 1;
+      for (size_t i = (hash & (high_bit - 1)) | high_bit;
+	   i < static_cast<size_t>(num_buckets_); i += high_bit << 1) {
+	bucket_address_table_[i] = low;
+      }
+    }
+  }
+
+  /*
+   * halve the directory as long as no bucket is as deep as it, and give the
+   * memory of the dropped half back
+   * NOTE: caller must hold directory_latch_ exclusively
+   */
+  template <typename K, typename V>
+  void ExtendibleHash<K, V>::ShrinkDirectory() {
+    while (global_depth_ > 0) {
+      for (int i = 0; i < num_buckets_; ++i) {
+	if (bucket_address_table_[i]->local_depth_ == global_depth_) {
+	  return;
 	}
       }
+      num_buckets_ /= 2;
+      global_depth_--;
+      bucket_address_table_.resize(num_buckets_);
+      bucket_address_table_.shrink_to_fit();
     }
   }
 
@@ -207,7 +313,6 @@ namespace cmudb {
   // debug only
   template <typename K, typename V>
   void ExtendibleHash<K, V>::Speak(int bucket_id) const {
-    // std::lock_guard<std::mutex> latch(global_table_lock_);
     assert(bucket_id < (1 << global_depth_));
     assert(bucket_id >= 0);
 
@@ -221,7 +326,6 @@ namespace cmudb {
 
   template <typename K, typename V>
   void ExtendibleHash<K, V>::SpeakAll() const {
-    // std::lock_guard<std::mutex> latch(global_table_lock_);
     // just for test, so ignore latch
     std::cout << "[";
     for (int i = 0; i < num_buckets_; ++i) {
@@ -4,15 +4,54 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be split into several independent instances. A page id always
+ * maps to the same instance (page_id % num_instances), and every instance has
+ * its own page table, free list, replacer and latch, so threads working on
+ * different pages rarely contend on the same latch. Each instance evicts with
+ * the replacement policy chosen at construction (LRU, CLOCK or 2Q). Page
+ * tables are fixed size open addressing tables with lock free lookups, so a
+ * hit only takes the instance latch.
+ *
+ * Disk I/O never happens under an instance latch. A frame being read stays
+ * write latched until its content is valid, so concurrent fetchers of the
+ * same page wait on that frame only. A dirty victim is written back while
+ * pinned and read latched, so it can still serve hits on the old page.
+ *
+ * Prefetch/PrefetchPages and WriteBackPages issue page reads or writes as
+ * one asynchronous batch and return without waiting for them, a read ahead
+ * page lands in an unpinned frame. TryFetchPage pins a page only if that
+ * needs no I/O. PeekPage finds a resident page for optimistic readers, which
+ * neither pin nor latch it, and validate what they read against the version
+ * of its frame.
+ *
+ * An optional flusher thread (RunFlusherThread) writes dirty pages back in
+ * the background, so that FindVictim mostly finds clean victims. Every
+ * interval it walks the cold end of each replacer (the next victims) and
+ * cleans the dirty pages there, and when more than the high watermark of the
+ * frames is dirty it keeps going until only the low watermark is. It never
+ * pins a page, so the replacement order stays untouched, and it skips pages
+ * whose log records are not persistent yet.
+ *
+ * FlushAllPages writes back one instance at a time, so writers keep running
+ * while a checkpoint flushes the pool.
  */
 
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "buffer/two_q_replacer.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
@@ -20,33 +59,93 @@ namespace cmudb {
   class BufferPoolManager {
   public:
     BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-		      LogManager *log_manager = nullptr);
-    
+		      LogManager *log_manager = nullptr,
+		      size_t num_instances = 1,
+		      ReplacerType replacer_type = ReplacerType::LRU);
+
     ~BufferPoolManager();
 
     Page *FetchPage(page_id_t page_id);
 
+    Page *TryFetchPage(page_id_t page_id);
+
+    // neither pins nor latches the page, see the definition
+    Page *PeekPage(page_id_t page_id);
+
     bool UnpinPage(page_id_t page_id, bool is_dirty);
-    
+
     bool FlushPage(page_id_t page_id);
 
-    Page *NewPage(page_id_t &page_id);
-  
+    void FlushAllPages();
+
+    // pages that may differ from disk: page id -> page lsn
+    void GetDirtyPages(std::unordered_map<page_id_t, lsn_t> &dirty_pages);
+
+    // the page id comes from extent if not nullptr
+    Page *NewPage(page_id_t &page_id, Extent *extent = nullptr);
+
     bool DeletePage(page_id_t page_id);
 
+    void Prefetch(page_id_t page_id);
+
+    void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+    void WriteBackPages(const std::vector<page_id_t> &page_ids);
+
+    // spawn a separate thread to write dirty pages back periodically
+    void RunFlusherThread(double high_dirty_ratio = FLUSHER_HIGH_DIRTY_RATIO,
+			  double low_dirty_ratio = FLUSHER_LOW_DIRTY_RATIO);
+    void StopFlusherThread();
+
+    inline size_t GetPoolSize() const { return pool_size_; }
+
+    inline size_t GetNumInstances() const { return num_instances_; }
+
     // test only
     int PinnedNum() const;
 
     std::vector<page_id_t> PinnedPageId() const;
 
+    int DirtyNum() const;
+
   private:
-    size_t pool_size_; // number of pages in buffer pool
-    Page *pages_;      // array of pages
+    // one independent slice of the buffer pool
+    struct BufferPoolInstance {
+      Page *pages_;      // first frame of this slice
+      size_t pool_size_; // number of frames in this slice
+      PageTable *page_table_;        // to keep track of pages
+      Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+      std::list<Page *> *free_list_; // to find a free page for replacement
+      std::mutex latch_;             // to protect shared data structure
+    };
+
+    inline BufferPoolInstance &GetInstance(page_id_t page_id) {
+      return instances_[static_cast<size_t>(page_id) % num_instances_];
+    }
+
+    bool FindVictim(BufferPoolInstance &instance,
+		    std::unique_lock<std::mutex> &latch, page_id_t page_id,
+		    Page *&page);
+
+    void FlushDirtyPages(BufferPoolInstance &instance);
+
+    void WriteBack(const std::vector<page_id_t> &page_ids, bool pinned_too);
+
+    size_t pool_size_;      // number of pages in buffer pool
+    size_t num_instances_;  // number of independent instances
+    Page *pages_;           // array of pages
+    FrameArena *frames_;    // content of the pages, PAGE_SIZE bytes each
     DiskManager *disk_manager_;
     LogManager *log_manager_;
-    HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-    Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-    std::list<Page *> *free_list_; // to find a free page for replacement
-    std::mutex latch_;             // to protect shared data structure
+    BufferPoolInstance *instances_;
+    // asynchronous page requests not completed yet
+    std::atomic<int> async_in_flight_;
+    // background flusher
+    std::thread flusher_thread_;
+    std::atomic<bool> flusher_running_;
+    std::mutex flusher_latch_;
+    std::condition_variable flusher_cv_;
+    double high_dirty_ratio_;
+    double low_dirty_ratio_;
   };
 } // namespace cmudb
@@ -0,0 +1,56 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) approximation of LRU. Every frame owns
+ * a fixed slot holding an "evictable" bit and a reference bit, so Insert and
+ * Erase are a single atomic operation on that slot and never allocate. Victim
+ * sweeps a clock hand over the slots, clearing reference bits until it finds
+ * an evictable frame that was not referenced since the last sweep.
+ *
+ * Values are mapped to slots by their distance from "base": a Page* relative
+ * to the first frame of the pool, or an int relative to 0.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+public:
+  ClockReplacer(size_t num_frames, T base);
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  void Peek(std::vector<T> &values, size_t max_count);
+
+private:
+  static constexpr uint8_t IN_REPLACER = 0x1;
+  static constexpr uint8_t REFERENCED = 0x2;
+
+  inline size_t FrameId(const T &value) const {
+    return static_cast<size_t>(value - base_);
+  }
+
+  size_t num_frames_;
+  T base_;
+  std::atomic<uint8_t> *frames_;  // per frame IN_REPLACER | REFERENCED
+  std::atomic<size_t> size_;      // number of evictable frames
+  size_t hand_;                   // next frame to inspect, protected by latch
+  std::mutex clock_hand_latch_;   // only sweeps serialize on this
+};
+
+} // namespace cmudb
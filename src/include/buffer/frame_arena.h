@@ -0,0 +1,46 @@
+/**
+ * frame_arena.h
+ *
+ * Memory holding the content of every buffer pool frame, apart from the page
+ * metadata. The arena is one anonymous mapping: backed by 2MB huge pages when
+ * the system has some reserved, otherwise by transparent huge pages where the
+ * kernel allows them, so that a large pool costs few TLB entries. Frames are
+ * aligned on memory pages, as O_DIRECT wants.
+ *
+ * The arena can be placed on NUMA nodes (interleaved over all of them or bound
+ * to one), and pre-faulted so that the first accesses don't pay for it.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class FrameArena {
+public:
+  FrameArena(size_t size, bool prefault = false,
+             NumaPolicy numa_policy = NumaPolicy::LOCAL, int numa_node = 0);
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  inline char *GetData() const { return data_; }
+  // mapped size, size rounded up to the page size of the mapping
+  inline size_t GetSize() const { return size_; }
+  // true if backed by reserved huge pages
+  inline bool UsesHugePages() const { return huge_pages_; }
+
+private:
+  void Place(NumaPolicy numa_policy, int numa_node);
+  void Prefault();
+
+  char *data_;
+  size_t size_;
+  bool huge_pages_;
+};
+
+} // namespace cmudb
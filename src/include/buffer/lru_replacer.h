@@ -33,6 +33,8 @@ public:
 
   size_t Size();
 
+  void Peek(std::vector<T> &values, size_t max_count);
+
 private:
   // add your member variables here
   std::unordered_map<T, typename std::list<T>::iterator> lru_key_itr_map_;
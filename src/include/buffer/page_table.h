@@ -0,0 +1,57 @@
+/**
+ * page_table.h
+ *
+ * Functionality: page id -> frame map of one buffer pool instance. An open
+ * addressing table with linear probing, sized at construction to a power of
+ * two at least twice the number of frames, so it never allocates nor grows.
+ *
+ * Insert and Remove must be serialized by the caller (the instance latch).
+ * Find takes no lock: a hit is a single probe sequence over atomic slots.
+ * Remove closes the hole it leaves by shifting later entries back, which
+ * bumps a version counter; a Find that misses while a Remove was in progress
+ * probes again, so it never reports a resident page as absent.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+class PageTable {
+public:
+  PageTable(size_t num_frames);
+
+  ~PageTable();
+
+  bool Find(page_id_t page_id, Page *&page) const;
+
+  void Insert(page_id_t page_id, Page *page);
+
+  bool Remove(page_id_t page_id);
+
+  inline size_t GetCapacity() const { return mask_ + 1; }
+
+private:
+  struct Slot {
+    std::atomic<page_id_t> page_id_; // INVALID_PAGE_ID when empty
+    std::atomic<Page *> page_;
+  };
+
+  // slot a page id probes first
+  inline size_t Home(page_id_t page_id) const {
+    // fibonacci hashing spreads the strided ids of one instance
+    return (static_cast<uint32_t>(page_id) * 2654435769u) >> shift_;
+  }
+
+  Slot *slots_;
+  size_t mask_;  // capacity - 1
+  int shift_;    // 32 - log2(capacity)
+  std::atomic<uint64_t> version_; // odd while a Remove shifts entries
+};
+
+} // namespace cmudb
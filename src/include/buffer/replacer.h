@@ -6,9 +6,13 @@
 #pragma once
 
 #include <cstdlib>
+#include <vector>
 
 namespace cmudb {
 
+// replacement policy used by the buffer pool manager
+enum class ReplacerType { LRU, CLOCK, TWO_Q };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -17,6 +21,10 @@ public:
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // up to max_count evictable values, the next victims first, left in place
+  virtual void Peek(std::vector<T> &values, size_t max_count) = 0;
+  // value no longer holds its page (deleted), drop any history kept for it
+  virtual void Discard(const T &value) { Erase(value); }
 };
 
 } // namespace cmudb
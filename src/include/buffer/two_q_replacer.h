@@ -0,0 +1,69 @@
+/**
+ * two_q_replacer.h
+ *
+ * Functionality: scan resistant 2Q replacement (Johnson & Shasha). A page
+ * seen for the first time enters A1in, a FIFO queue limited to a quarter of
+ * the frames; hitting it again while it is still in A1in is treated as a
+ * correlated reference and does not promote it. When a page is evicted from
+ * A1in its id is remembered in A1out, a ghost queue without frames. Only a
+ * page referenced again while remembered in A1out is loaded into Am, the LRU
+ * queue that holds the working set. A sequential pass therefore only cycles
+ * through A1in and never pushes the pages of Am out.
+ *
+ * History is kept per page id rather than per frame, so it outlives the frame
+ * the page was loaded in. Pinned pages keep their queue position but are
+ * skipped when picking a victim.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace cmudb {
+
+template <typename T> class TwoQReplacer : public Replacer<T> {
+public:
+  TwoQReplacer(size_t num_frames);
+
+  ~TwoQReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  void Discard(const T &value);
+
+  size_t Size();
+
+  void Peek(std::vector<T> &values, size_t max_count);
+
+private:
+  struct Entry {
+    T value;
+    bool in_am;     // false: the page is in A1in
+    bool evictable; // unpinned
+    typename std::list<page_id_t>::iterator position;
+  };
+
+  bool VictimFrom(std::list<page_id_t> &queue, T &value);
+
+  size_t kin_;  // max resident pages in A1in before it gets reclaimed first
+  size_t kout_; // max page ids remembered in A1out
+  std::unordered_map<page_id_t, Entry> resident_;
+  std::list<page_id_t> a1in_; // front is the newest page
+  std::list<page_id_t> am_;   // front is the most recently used page
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_map_;
+  size_t size_; // number of evictable pages
+
+  std::mutex two_q_replacer_latch_;
+};
+
+} // namespace cmudb
@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace cmudb {
@@ -16,15 +17,47 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds FLUSHER_INTERVAL;
+
+// size of a data page in byte, a database keeps the one it was created with.
+// Set it before creating any disk manager, buffer pool or log manager
+extern int PAGE_SIZE;
+
+// size of buffer pool, picked when the storage engine is loaded
+extern size_t BUFFER_POOL_SIZE;
+
+// placement of the buffer pool frames on NUMA nodes: where the first thread
+// touching them runs, spread over every node, or on BUFFER_POOL_NUMA_NODE
+enum class NumaPolicy { LOCAL, INTERLEAVE, BIND };
+extern NumaPolicy BUFFER_POOL_NUMA_POLICY;
+extern int BUFFER_POOL_NUMA_NODE;
+
+// fault the buffer pool frames in when the pool is created
+extern bool BUFFER_POOL_PREFAULT;
+
+// B+ tree lookups restart this many times without latching, then latch. 0
+// makes every lookup latch
+extern int OPTIMISTIC_LOOKUP_ATTEMPTS;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
+#define FILE_HEADER_PAGE_ID 0 // identifies the file, holds its page size
 #define HEADER_PAGE_ID 1   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
-#define LOG_BUFFER_SIZE                                                            \
-  ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
+#define MIN_PAGE_SIZE 512  // page sizes are powers of two in this range
+#define MAX_PAGE_SIZE 16384
+#define DEFAULT_PAGE_SIZE 4096         // page size of new databases
+#define DEFAULT_BUFFER_POOL_SIZE 1024  // frames of the storage engine
+#define LOG_BUFFER_PAGES 16            // size of a log buffer in pages
+#define LOG_BUFFER_SIZE (LOG_BUFFER_PAGES * PAGE_SIZE) // same in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
-#define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define ASYNC_IO_QUEUE_DEPTH 64        // max page requests batched to disk
+#define TABLE_READ_AHEAD_PAGES 8       // heap pages kept in flight by scans
+#define INDEX_READ_AHEAD_PAGES 8       // max leaves kept in flight by scans
+#define FLUSHER_HIGH_DIRTY_RATIO 0.5   // flusher cleans past the cold end
+#define FLUSHER_LOW_DIRTY_RATIO 0.25   // above this fraction of dirty frames
+#define EXTENT_SIZE 64                 // pages reserved at once per table/index
+#define BULK_LOAD_FILL_FACTOR 0.9      // how full bulk loaded B+ tree pages are
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
@@ -5,6 +5,8 @@
 
 #pragma once
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "common/config.h"
@@ -22,8 +24,14 @@ public:
   void Commit(Transaction *txn);
   void Abort(Transaction *txn);
 
+  // snapshot of the running transactions: txn id -> last lsn
+  void GetActiveTxns(std::unordered_map<txn_id_t, lsn_t> &active_txns);
+
 private:
   std::atomic<txn_id_t> next_txn_id_;
+  // transactions begun and not committed nor aborted yet
+  std::unordered_map<txn_id_t, Transaction *> active_txns_;
+  std::mutex active_txns_latch_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
 };
@@ -0,0 +1,109 @@
+/**
+ * async_io.h
+ *
+ * Asynchronous positional I/O on one file descriptor. Requests are prepared,
+ * then handed to the disk in a batch by Submit, and a callback runs once each
+ * of them completes. No thread blocks per request.
+ *
+ * The requests go through io_uring when the kernel offers it (a single
+ * io_uring_enter submits the whole batch, a reaper thread collects the
+ * completions). Otherwise a small pool of worker threads runs them with
+ * pread/pwrite. Callbacks run on the reaper or worker threads, they must be
+ * short and must neither prepare nor wait for requests of the same AsyncIO.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class AsyncIO {
+public:
+  // called with the number of bytes transferred, or -errno on failure
+  typedef std::function<void(ssize_t)> Callback;
+
+  AsyncIO(int fd, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+          bool use_io_uring = true);
+  // waits for every submitted request
+  ~AsyncIO();
+
+  AsyncIO(const AsyncIO &) = delete;
+  AsyncIO &operator=(const AsyncIO &) = delete;
+
+  // queue a request, it reaches the disk at the latest on the next Submit
+  void PrepareRead(char *buffer, size_t size, off_t offset, Callback callback);
+  void PrepareWrite(const char *buffer, size_t size, off_t offset,
+                    Callback callback);
+  // hand every prepared request to the disk
+  void Submit();
+  // block until every request prepared so far has completed
+  void Wait();
+
+  inline bool UsesIOUring() const { return ring_fd_ != -1; }
+
+private:
+  struct Request {
+    bool is_write;
+    // buffer and size, in the form io_uring reads them
+    iovec iov;
+    off_t offset;
+    Callback callback;
+  };
+
+  void Prepare(Request *request);
+  void Complete(Request *request, ssize_t result);
+
+  // io_uring backend
+  bool SetupRing(size_t queue_depth);
+  void SubmitRing(std::unique_lock<std::mutex> &lock);
+  void ReapRing();
+  // thread pool backend
+  void RunWorker();
+
+  int fd_;
+  // requests prepared or submitted and not completed yet, bounded by
+  // queue_depth_ so that the completion queue never overflows
+  size_t in_flight_;
+  size_t queue_depth_;
+  std::mutex latch_;
+  std::condition_variable completed_;
+
+  // io_uring, ring_fd_ is -1 when not in use
+  int ring_fd_;
+  void *sq_ring_;
+  size_t sq_ring_size_;
+  void *cq_ring_;
+  size_t cq_ring_size_;
+  void *sqes_;
+  size_t sqes_size_;
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  void *cqes_;
+  // prepared in the submission queue but not yet passed to the kernel
+  unsigned to_submit_;
+  std::thread reaper_;
+
+  // thread pool
+  std::vector<Request *> prepared_;
+  std::deque<Request *> queue_;
+  std::condition_variable queued_;
+  std::vector<std::thread> workers_;
+  bool shutdown_;
+};
+
+} // namespace cmudb
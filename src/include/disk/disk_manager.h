@@ -5,33 +5,88 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are read and written with positional pread/pwrite on a file
+ * descriptor, so concurrent page I/O needs no lock. With direct_io the file is
+ * opened with O_DIRECT and bypasses the OS page cache, page data that isn't
+ * suitably aligned goes through an aligned per thread buffer.
+ *
+ * Page I/O can also be asynchronous: ReadPageAsync/WritePageAsync queue a
+ * request, SubmitAsync hands the batch to the disk (io_uring when available,
+ * worker threads otherwise) and the callback runs when the page is done.
+ *
+ * Allocated pages are tracked by a bitmap kept in a free space map file next
+ * to the database (db_file with the extension ".fsm"), one bit per page id.
+ * Deallocated page ids are handed out again, lowest first, and the next page
+ * id survives reopening the database. A table heap or an index allocates its
+ * pages from an extent, EXTENT_SIZE contiguous page ids reserved for it, so
+ * that its pages are contiguous in the file.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io.h"
 
 namespace cmudb {
 
+/**
+ * Page ids reserved for one object, handed out in order by
+ * DiskManager::AllocatePage. The reservation is not persisted, page ids not
+ * handed out yet are free again once the database is reopened
+ */
+class Extent {
+  friend class DiskManager;
+
+public:
+  Extent() = default;
+  Extent(const Extent &) = delete;
+  Extent &operator=(const Extent &) = delete;
+
+private:
+  page_id_t next_page_id_ = INVALID_PAGE_ID;
+  page_id_t end_page_id_ = INVALID_PAGE_ID;
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, bool direct_io = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
   void ReadPage(page_id_t page_id, char *page_data);
 
+  // asynchronous page I/O, page_data must stay valid until callback runs
+  void WritePageAsync(page_id_t page_id, const char *page_data,
+                      std::function<void()> callback);
+  void ReadPageAsync(page_id_t page_id, char *page_data,
+                     std::function<void()> callback);
+  // start every asynchronous page request queued so far
+  void SubmitAsync();
+  // wait for every asynchronous page request queued so far
+  void WaitAsync();
+
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
+  // bytes of log written so far
+  int GetLogSize();
 
-  page_id_t AllocatePage();
+  // from extent if not nullptr, reserving a new one when it is used up
+  page_id_t AllocatePage(Extent *extent = nullptr);
   void DeallocatePage(page_id_t page_id);
+  // true if page_id is allocated and not deallocated since
+  bool IsAllocated(page_id_t page_id);
 
   int GetNumFlushes() const;
+  // true if page I/O bypasses the OS page cache
+  bool IsDirectIO() const;
   bool GetFlushState() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
@@ -41,10 +96,35 @@ private:
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  bool DirectIOFallback();
+  void GrowFileSize(int64_t end);
+  void OpenFreeSpaceMap(const std::string &fsm_file);
+  page_id_t FindFreePage();
+  void ReserveExtent(Extent *extent);
+  void LowerHighWaterMark();
+  // allocated or reserved
+  inline bool IsTaken(page_id_t page_id) {
+    return ((free_space_map_[page_id / 8] | reserved_[page_id / 8]) &
+            (1 << (page_id % 8))) != 0;
+  }
+  void WriteFreeSpaceMap(size_t offset, size_t size);
+  // descriptor of the db file, accessed with pread/pwrite only
+  int db_fd_;
+  std::atomic<bool> direct_io_;
+  // db file size, grown by page writes instead of asking stat on every read
+  std::atomic<int64_t> db_file_size_;
+  AsyncIO *async_io_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  // free space map, one bit per page id set while the page is allocated
+  int fsm_fd_;
+  std::vector<uint8_t> free_space_map_;
+  // reserved by an extent and not allocated yet, in memory only
+  std::vector<uint8_t> reserved_;
+  std::mutex fsm_latch_;
+  // pages below are all taken
+  page_id_t free_hint_;
+  // high-water mark, every page from there on is free
+  page_id_t next_page_id_;
   int num_flushes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
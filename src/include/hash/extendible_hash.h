@@ -5,6 +5,14 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * Concurrency: every bucket has its own latch, and the directory is guarded
+ * by a reader-writer latch. Find, Remove, Insert and bucket splits only hold
+ * the directory latch in shared mode plus the latch of the bucket they touch;
+ * doubling the directory, merging buckets and halving the directory are the
+ * only operations holding it exclusively.
+ * Directory slots are read and written atomically, so a split can redirect
+ * the slots of its bucket while other threads look up unrelated buckets.
  */
 
 #pragma once
@@ -16,6 +24,7 @@
 #include <memory>
 #include <mutex>
 
+#include "common/rwmutex.h"
 #include "hash/hash_table.h"
 
 namespace cmudb {
@@ -42,26 +51,28 @@ namespace cmudb {
     struct Bucket {
       int local_depth_; 
       std::vector<std::pair<K, V>>  kv_records_;
+      std::mutex latch_; // protects local_depth_ and kv_records_
       Bucket(int local_depth) {
 	this->local_depth_ = local_depth;
 	this->kv_records_ = {};
       }
     };
+
+    // bucket covering hash, returned latched
+    std::shared_ptr<Bucket> LockBucket(size_t hash);
+    void SplitBucket(const std::shared_ptr<Bucket> &bucket, size_t hash);
+    void DoubleDirectory();
+    void MergeBucket(size_t hash);
+    void ShrinkDirectory();
+
     size_t size_;
-    int global_depth_ = 0;
+    int global_depth_ = 0; // only changes under exclusive directory_latch_
 
 	  // buckets number, must be 2^n
 	  int num_buckets_ = 1;
     std::vector<std::shared_ptr<Bucket>> bucket_address_table_;
 
-    // latches
-    // TODO:
-    //    use finer granularity(such as per buckets per locks)
-    /* mutable std::mutex global_depth_latch_; */
-    /* mutable std::mutex global_num_buckets_latch_; */
-    /* mutable std::vector<std::mutex> bucket_latch_table_; */
-    /* std::condition_variable condition_; */
-
-    mutable std::mutex global_table_lock_;
+    // shared by every operation, exclusive when doubling the directory
+    mutable RWMutex directory_latch_;
   };
 } // namespace cmudb
@@ -11,6 +11,7 @@
  */
 #pragma once
 
+#include <functional>
 #include <queue>
 #include <vector>
 #include <mutex>
@@ -42,6 +43,15 @@ public:
   bool Insert(const KeyType &key, const ValueType &value,
               Transaction *transaction = nullptr);
 
+  // Build this empty B+ tree bottom-up from pairs in ascending key order,
+  // returned by next until it returns false.
+  bool BulkLoad(const std::function<bool(KeyType &, ValueType &)> &next,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
+  // Same from pairs in any order, sorted first.
+  bool BulkLoad(std::vector<MappingType> &items,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -78,6 +88,8 @@ public:
   void SayTransactionPageSet(Transaction* txn);
 
 private:
+  bool GetValueOptimistic(const KeyType &key, ValueType &value, bool &found);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
@@ -89,6 +101,13 @@ private:
 
   template <typename N> N *Split(N *node);
 
+  void WriteLeaf(const std::vector<MappingType> &items,
+                 B_PLUS_TREE_LEAF_PAGE_TYPE *&prev_leaf,
+                 std::vector<std::pair<KeyType, page_id_t>> &children);
+
+  void BuildInternalLevel(std::vector<std::pair<KeyType, page_id_t>> &children,
+                          double fill_factor);
+
   template <typename N>
     bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
 
@@ -98,10 +117,16 @@ private:
       BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
       int index, Transaction *transaction = nullptr);
 
-  template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
+  template <typename N> bool Redistribute(N *neighbor_node, N *node, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
+  Page *FindLeafPageOptimistic(const KeyType &key, Transaction *txn,
+                               BPlusTreeActionType type);
+
+  bool IsSafe(BPlusTreePage *node, const KeyType &key,
+              BPlusTreeActionType type);
+
   void UpdateRootPageId(int insert_record = false);
 
   // member variable
@@ -111,6 +136,8 @@ private:
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   std::mutex root_id_latch_;
+  // nodes are allocated from it, so that the leaf chain is contiguous on disk
+  Extent extent_;
 };
 
 } // namespace cmudb
@@ -34,6 +34,9 @@ public:
   void ScanKey(const Tuple &key, std::vector<RID> &result,
                Transaction *transaction = nullptr) override;
 
+  void BulkLoad(std::vector<std::pair<Tuple, RID>> &entries,
+                Transaction *transaction = nullptr) override;
+
 protected:
   // comparator for key
   KeyComparator comparator_;
@@ -0,0 +1,89 @@
+/**
+ * disk_extendible_hash.h
+ *
+ * Disk resident extendible hash table: one directory page plus bucket pages,
+ * all living in the buffer pool. A point lookup fetches the directory and a
+ * single bucket, whatever the number of keys.
+ * (1) We only support unique key
+ * (2) support insert & remove
+ * (3) A full bucket splits (doubling the directory if needed), a sparse
+ *     bucket merges with its split image and the directory halves when it can
+ * (4) Once the directory page is full, buckets chain overflow pages
+ *
+ * The directory page id is recorded in the header page under the index name,
+ * like the root of a B+ tree. Lookups share a table latch, modifications hold
+ * it exclusively.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/rwmutex.h"
+#include "concurrency/transaction.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+#define DISK_EXTENDIBLE_HASH_TYPE                                              \
+  DiskExtendibleHash<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class DiskExtendibleHash {
+public:
+  explicit DiskExtendibleHash(const std::string &name,
+                              BufferPoolManager *buffer_pool_manager,
+                              const KeyComparator &comparator,
+                              page_id_t directory_page_id = INVALID_PAGE_ID);
+
+  // Returns true if no page was ever allocated for this table.
+  bool IsEmpty() const;
+
+  // Insert a key-value pair, false if the key already exists.
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  // Remove a key and its value.
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  // expose for test purpose
+  page_id_t GetDirectoryPageId() const { return directory_page_id_; }
+
+  uint32_t GetGlobalDepth();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+
+  HashTableDirectoryPage *FetchDirectoryPage();
+
+  HASH_TABLE_BUCKET_PAGE_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+
+  HASH_TABLE_BUCKET_PAGE_TYPE *NewBucketPage(page_id_t &bucket_page_id);
+
+  void StartNewTable();
+
+  void SplitBucket(HashTableDirectoryPage *directory, uint32_t bucket_idx,
+                   HASH_TABLE_BUCKET_PAGE_TYPE *bucket);
+
+  void InsertIntoOverflow(HASH_TABLE_BUCKET_PAGE_TYPE *bucket,
+                          const KeyType &key, const ValueType &value);
+
+  void Merge(HashTableDirectoryPage *directory, uint32_t hash);
+
+  void UpdateDirectoryPageId(int insert_record = false);
+
+  // member variable
+  std::string index_name_;
+  page_id_t directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  RWMutex table_latch_;
+};
+
+} // namespace cmudb
@@ -1,98 +1,213 @@
-/**
- * generic_key.h
- *
- * Key used for indexing with opaque data
- *
- * This key type uses an fixed length array to hold data for indexing
- * purposes, the actual size of which is specified and instantiated
- * with a template argument.
- */
-#pragma once
-
-#include <cstring>
-
-#include "table/tuple.h"
-#include "type/value.h"
-
-namespace cmudb {
-template <size_t KeySize>
-class GenericKey {
-public:
-  inline void SetFromKey(const Tuple &tuple) {
-    // intialize to 0
-    memset(data, 0, KeySize);
-    memcpy(data, tuple.GetData(), tuple.GetLength());
-  }
-
-  // NOTE: for test purpose only
-  inline void SetFromInteger(int64_t key) {
-    memset(data, 0, KeySize);
-    memcpy(data, &key, sizeof(int64_t));
-  }
-
-  inline Value ToValue(Schema *schema, int column_id) const {
-    const char *data_ptr;
-    const TypeId column_type = schema->GetType(column_id);
-    const bool is_inlined = schema->IsInlined(column_id);
-    if (is_inlined) {
-      data_ptr = (data + schema->GetOffset(column_id));
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(
-          const_cast<char *>(data + schema->GetOffset(column_id)));
-      data_ptr = (data + offset);
-    }
-    return Value::DeserializeFrom(data_ptr, column_type);
-  }
-
-  // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline int64_t ToString() const {
-    return *reinterpret_cast<int64_t *>(const_cast<char *>(data));
-  }
-
-  // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  friend std::ostream &operator<<(std::ostream &os, const GenericKey &key) {
-    os << key.ToString();
-    return os;
-  }
-
-  // actual location of data, extends past the end.
-  char data[KeySize];
-};
-
-/**
- * Function object returns true if lhs < rhs, used for trees
- */
-template <size_t KeySize> class GenericComparator {
-public:
-  inline int operator()(const GenericKey<KeySize> &lhs,
-                        const GenericKey<KeySize> &rhs) const {
-    int column_count = key_schema_->GetColumnCount();
-
-    for (int i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CMP_TRUE)
-        return -1;
-
-      if (lhs_value.CompareGreaterThan(rhs_value) == CMP_TRUE)
-        return 1;
-    }
-    // equals
-    return 0;
-  }
-
-  GenericComparator(const GenericComparator &other) {
-    this->key_schema_ = other.key_schema_;
-  }
-
-  // constructor
-  GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
-
-private:
-  Schema *key_schema_;
-};
-
-} // namespace cmudb
+/**
+ * generic_key.h
+ *
+ * Key used for indexing with opaque data
+ *
+ * This key type uses an fixed length array to hold data for indexing
+ * purposes, the actual size of which is specified and instantiated
+ * with a template argument.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "table/tuple.h"
+#include "type/limits.h"
+#include "type/type.h"
+
+namespace cmudb {
+/*
+ * Bytes GenericKey::SetFromKey takes for keys of key_schema, as long as their
+ * varchars fit their columns and hold no 0 byte (escaped into two)
+ */
+inline size_t GetEncodedKeySize(Schema *key_schema) {
+  size_t size = 0;
+  for (int i = 0; i < key_schema->GetColumnCount(); i++) {
+    if (key_schema->GetType(i) == TypeId::VARCHAR) {
+      size += key_schema->GetVariableLength(i) + 2;
+    } else {
+      size += Type::GetTypeSize(key_schema->GetType(i));
+    }
+  }
+  return size;
+}
+
+template <size_t KeySize>
+class GenericKey {
+public:
+  /*
+   * Encode the key tuple so that memcmp orders keys like their values:
+   * integers big-endian with the sign bit flipped, decimals by their bits
+   * (all flipped when negative), varchars with 0x00 escaped as 0x00 0xff and
+   * closed by 0x00 0x01 (0x00 0x00 for null). Nulls of fixed size types are
+   * their sentinel values and sort first, timestamps last. Columns are
+   * concatenated. Returns false if they don't fit in KeySize: the cut off key
+   * could equal another one, it must not be stored.
+   */
+  inline bool SetFromKey(const Tuple &tuple, Schema *key_schema) {
+    memset(data, 0, KeySize);
+    size_t size = 0;
+    for (int i = 0; i < key_schema->GetColumnCount(); i++) {
+      const char *column = tuple.GetData() + key_schema->GetOffset(i);
+      TypeId type = key_schema->GetType(i);
+      switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT: {
+        size_t length = Type::GetTypeSize(type);
+        uint64_t bits = 0;
+        memcpy(&bits, column, length);
+        // flip the sign bit of the column width
+        PutBigEndian(size, bits ^ (1ull << (8 * length - 1)), length);
+        break;
+      }
+      case TypeId::TIMESTAMP:
+        PutBigEndian(size, *reinterpret_cast<const uint64_t *>(column), 8);
+        break;
+      case TypeId::DECIMAL: {
+        uint64_t bits = *reinterpret_cast<const uint64_t *>(column);
+        bits = (bits >> 63) ? ~bits : bits ^ (1ull << 63);
+        PutBigEndian(size, bits, 8);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        int32_t offset = *reinterpret_cast<const int32_t *>(column);
+        const char *storage = tuple.GetData() + offset;
+        uint32_t length = *reinterpret_cast<const uint32_t *>(storage);
+        if (length == PELOTON_VALUE_NULL) {
+          PutByte(size, 0);
+          PutByte(size, 0);
+          break;
+        }
+        const char *chars = storage + sizeof(uint32_t);
+        // strings are stored with their terminating 0
+        if (length > 0 && chars[length - 1] == '\0') {
+          length--;
+        }
+        for (uint32_t j = 0; j < length && size < KeySize; j++) {
+          PutByte(size, chars[j]);
+          if (chars[j] == '\0') {
+            PutByte(size, static_cast<char>(0xff));
+          }
+        }
+        PutByte(size, 0);
+        PutByte(size, 1);
+        break;
+      }
+      default:
+        break;
+      }
+    }
+    return size <= KeySize;
+  }
+
+  // NOTE: for test purpose only
+  // encoded as a BIGINT column
+  inline void SetFromInteger(int64_t key) {
+    memset(data, 0, KeySize);
+    size_t size = 0;
+    PutBigEndian(size, static_cast<uint64_t>(key) ^ (1ull << 63), 8);
+  }
+
+  // NOTE: for test purpose only
+  // decode the first 8 bytes as a BIGINT column
+  inline int64_t ToString() const {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 8; i++) {
+      bits = (bits << 8) |
+             (i < KeySize ? static_cast<unsigned char>(data[i]) : 0);
+    }
+    return static_cast<int64_t>(bits ^ (1ull << 63));
+  }
+
+  // NOTE: for test purpose only
+  // decode the first 8 bytes as a BIGINT column
+  friend std::ostream &operator<<(std::ostream &os, const GenericKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  // actual location of data, extends past the end.
+  char data[KeySize];
+
+private:
+  inline void PutByte(size_t &size, char byte) {
+    if (size < KeySize) {
+      data[size] = byte;
+    }
+    size++;
+  }
+
+  // the low length bytes of bits, most significant first
+  inline void PutBigEndian(size_t &size, uint64_t bits, size_t length) {
+    for (size_t i = length; i > 0; i--) {
+      PutByte(size, static_cast<char>(bits >> (8 * (i - 1))));
+    }
+  }
+};
+
+/**
+ * Function object returns true if lhs < rhs, used for trees
+ * Keys are normalized by SetFromKey, they compare like big-endian words.
+ * Only the words the key schema can fill are looked at: one load and one
+ * integer comparison for keys such as INTEGER, BIGINT or (INTEGER, INTEGER).
+ */
+template <size_t KeySize> class GenericComparator {
+public:
+  inline int operator()(const GenericKey<KeySize> &lhs,
+                        const GenericKey<KeySize> &rhs) const {
+    if (KeySize < sizeof(uint32_t)) {
+      return memcmp(lhs.data, rhs.data, KeySize);
+    }
+    if (KeySize < sizeof(uint64_t)) {
+      uint32_t lhs_word = LoadWord<uint32_t>(lhs.data);
+      uint32_t rhs_word = LoadWord<uint32_t>(rhs.data);
+      return lhs_word == rhs_word ? 0 : (lhs_word < rhs_word ? -1 : 1);
+    }
+    // fixed for the small key sizes, the loop goes away
+    size_t words = KeySize == sizeof(uint64_t) ? 1 : words_;
+    for (size_t i = 0; i < words; i++) {
+      uint64_t lhs_word = LoadWord<uint64_t>(lhs.data + i * sizeof(uint64_t));
+      uint64_t rhs_word = LoadWord<uint64_t>(rhs.data + i * sizeof(uint64_t));
+      if (lhs_word != rhs_word) {
+        return lhs_word < rhs_word ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  GenericComparator(const GenericComparator &other) = default;
+
+  // constructor, count the words encoded for key_schema
+  GenericComparator(Schema *key_schema) : words_(KeySize / sizeof(uint64_t)) {
+    size_t length = 0;
+    for (int i = 0; i < key_schema->GetColumnCount(); i++) {
+      if (key_schema->GetType(i) == TypeId::VARCHAR) {
+        return;
+      }
+      length += Type::GetTypeSize(key_schema->GetType(i));
+    }
+    words_ = std::min(words_, (length + sizeof(uint64_t) - 1) /
+                                  sizeof(uint64_t));
+  }
+
+private:
+  // the bytes at data as a big-endian word
+  template <typename Word> static inline Word LoadWord(const char *data) {
+    Word word;
+    memcpy(&word, data, sizeof(Word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = sizeof(Word) == sizeof(uint64_t) ? __builtin_bswap64(word)
+                                            : __builtin_bswap32(word);
+#endif
+    return word;
+  }
+
+  // 8 byte words of the key that can differ, the rest is always 0
+  size_t words_;
+};
+
+} // namespace cmudb
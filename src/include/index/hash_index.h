@@ -0,0 +1,42 @@
+/**
+ * hash_index.h
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "index/disk_extendible_hash.h"
+#include "index/index.h"
+
+namespace cmudb {
+
+#define HASH_INDEX_TYPE HashIndex<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashIndex : public Index {
+
+public:
+  HashIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
+            page_id_t directory_page_id = INVALID_PAGE_ID);
+
+  ~HashIndex() {}
+
+  void InsertEntry(const Tuple &key, RID rid,
+                   Transaction *transaction = nullptr) override;
+
+  void DeleteEntry(const Tuple &key,
+                   Transaction *transaction = nullptr) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> &result,
+               Transaction *transaction = nullptr) override;
+
+protected:
+  // comparator for key
+  KeyComparator comparator_;
+  // container
+  DiskExtendibleHash<KeyType, ValueType, KeyComparator> container_;
+};
+
+} // namespace cmudb
@@ -1,8 +1,15 @@
 /**
  * index_iterator.h
  * For range scan of b+ tree
+ *
+ * The iterator prefetches the next sibling leaves while the scan consumes
+ * the current one. The window adapts to the scan: it doubles whenever the
+ * scan reaches a leaf still being read, and shrinks by one after a window
+ * worth of leaves were all ready in time, within [1, max read ahead].
  */
 #pragma once
+#include <deque>
+
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -23,12 +30,25 @@ public:
 
   IndexIterator &operator++();
 
+  // upper bound of the read ahead window, 0 disables read ahead
+  void SetMaxReadAhead(size_t max_read_ahead);
+
 private:
+  void ReadAhead();
+
   // add your own private member variables here
   B_PLUS_TREE_LEAF_PAGE_TYPE *current_page_;
   BufferPoolManager *buffer_pool_manager_;
   int current_index_in_page_;
   int max_size_in_current_page_;
+  // keys are stored in parts, the current pair is put together here
+  MappingType item_;
+  // leaves being read ahead, in chain order after the current one
+  std::deque<page_id_t> read_ahead_;
+  size_t read_ahead_window_;
+  size_t max_read_ahead_;
+  // leaves found ready in a row since the window last changed
+  size_t read_ahead_hits_;
 };
 
 } // namespace cmudb
@@ -0,0 +1,32 @@
+/**
+ * checkpoint_manager.h
+ * Fuzzy checkpoints bound the work of recovery: redo only has to start from
+ * the last complete checkpoint instead of the beginning of the log.
+ */
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "logging/log_manager.h"
+
+namespace cmudb {
+
+class CheckpointManager {
+public:
+  CheckpointManager(TransactionManager *transaction_manager,
+                    LogManager *log_manager,
+                    BufferPoolManager *buffer_pool_manager)
+      : transaction_manager_(transaction_manager), log_manager_(log_manager),
+        buffer_pool_manager_(buffer_pool_manager) {}
+
+  // take a checkpoint while transactions keep running
+  void Checkpoint();
+
+private:
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+};
+
+} // namespace cmudb
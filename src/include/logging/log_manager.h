@@ -26,8 +26,16 @@ public:
     
     log_offset_ = 0;
     flush_offset_ = 0;
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE]; 
+    // records are appended after whatever an earlier run left in the log
+    log_file_offset_ = disk_manager->GetLogSize();
+    last_lsn_ = INVALID_LSN;
+    flush_lsn_ = INVALID_LSN;
+    flushing_ = false;
+    flush_requested_ = false;
+    flush_thread_ = nullptr;
+    log_buffer_size_ = LOG_BUFFER_SIZE;
+    log_buffer_ = new char[log_buffer_size_];
+    flush_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogManager() {
@@ -40,9 +48,12 @@ public:
   void RunFlushThread();
   void StopFlushThread();
 
-  // append a log record into log buffer
-  lsn_t AppendLogRecord(LogRecord &log_record);
+  // append a log record into log buffer, log_offset receives the position
+  // of the record in the log file
+  lsn_t AppendLogRecord(LogRecord &log_record, int *log_offset = nullptr);
   bool SafetyForAppend(LogRecord &log_record);
+  // write every record appended so far to disk and wait for it
+  void Flush();
 
   // get/set helper functions
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
@@ -57,19 +68,37 @@ private:
   std::atomic<lsn_t> next_lsn_;
   // log records before & include persistent_lsn_ have been written to disk
   std::atomic<lsn_t> persistent_lsn_;
-  // log buffer related
+  // log buffer related, both buffers are log_buffer_size_ bytes
+  int log_buffer_size_;
   char *log_buffer_;
   int log_offset_;
   char *flush_buffer_;
   int flush_offset_;
+  // log file offset of the first byte in log_buffer_
+  int log_file_offset_;
+  // lsn of the last record in log_buffer_
+  lsn_t last_lsn_;
+  // lsn of the last record in flush_buffer_
+  lsn_t flush_lsn_;
+  // flush_buffer_ holds records not on disk yet, it can't be swapped again
+  // until they are
+  bool flushing_;
+  // an appender handed the write of flush_buffer_ to the flush thread
+  bool flush_requested_;
   // latch to protect shared member variables
   std::mutex latch_;
   // flush thread
   std::thread *flush_thread_;
   // for notifying flush thread
   std::condition_variable cv_;
+  // for waiting until flush_buffer_ is written
+  std::condition_variable flushed_cv_;
   // disk manager
   DiskManager *disk_manager_;
+
+  void FlushLogBuffer(std::unique_lock<std::mutex> &latch);
+  void SwapLogBuffer();
+  void WriteFlushBuffer(std::unique_lock<std::mutex> &latch);
 };
 
 } // namespace cmudb
@@ -23,9 +23,15 @@
  *-------------------------------------------------------------
  * | HEADER | prev_page_id |
  *-------------------------------------------------------------
+ * For end checkpoint type log record (begin checkpoint is HEADER only)
+ *------------------------------------------------------------------------------
+ * | HEADER | dirty_page_count | page_id | page_lsn | ... |
+ * | active_txn_count | txn_id | last_lsn | ... |
+ *------------------------------------------------------------------------------
  */
 #pragma once
 #include <cassert>
+#include <unordered_map>
 
 #include "common/config.h"
 #include "table/tuple.h"
@@ -44,6 +50,10 @@ enum class LogRecordType {
   ABORT,
   // when create a new page in heap table
   NEWPAGE,
+  // fuzzy checkpoint, the end record carries the dirty page table and the
+  // active transaction table taken after the begin record
+  BEGIN_CHECKPOINT,
+  END_CHECKPOINT,
 };
 
 class LogRecord {
@@ -101,6 +111,20 @@ public:
     size_ = HEADER_SIZE + sizeof(page_id_t);
   }
 
+  // constructor for END_CHECKPOINT type
+  LogRecord(LogRecordType log_record_type,
+            const std::unordered_map<page_id_t, lsn_t> &dirty_pages,
+            const std::unordered_map<txn_id_t, lsn_t> &active_txns)
+      : lsn_(INVALID_LSN), txn_id_(INVALID_TXN_ID), prev_lsn_(INVALID_LSN),
+        log_record_type_(log_record_type), dirty_pages_(dirty_pages),
+        active_txns_(active_txns) {
+    assert(log_record_type == LogRecordType::END_CHECKPOINT);
+    // calculate log record size
+    size_ = HEADER_SIZE + 2 * sizeof(int32_t) +
+            dirty_pages.size() * (sizeof(page_id_t) + sizeof(lsn_t)) +
+            active_txns.size() * (sizeof(txn_id_t) + sizeof(lsn_t));
+  }
+
   ~LogRecord() {}
 
   inline RID &GetDeleteRID() { return delete_rid_; }
@@ -111,6 +135,14 @@ public:
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline std::unordered_map<page_id_t, lsn_t> &GetDirtyPages() {
+    return dirty_pages_;
+  }
+
+  inline std::unordered_map<txn_id_t, lsn_t> &GetActiveTxns() {
+    return active_txns_;
+  }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -158,6 +190,10 @@ private:
 
   // case4: for new page opeartion
   page_id_t prev_page_id_ = INVALID_PAGE_ID;
+
+  // case5: for end checkpoint, page id -> page lsn and txn id -> last lsn
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;
   const static int HEADER_SIZE = 20;
 }; // namespace cmudb
 
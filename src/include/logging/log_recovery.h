@@ -21,7 +21,8 @@ public:
       : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager),
         offset_(0) {
     // global transaction through recovery phase
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+    log_buffer_size_ = LOG_BUFFER_SIZE;
+    log_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogRecovery() {
@@ -34,6 +35,8 @@ public:
   bool DeserializeLogRecord(const char *data, LogRecord &log_record);
 
 private:
+  void RedoLogRecord(LogRecord &log_record);
+
   // TODO: you can add whatever member variable here
   // Don't forget to initialize newly added variable in constructor
   DiskManager *disk_manager_;
@@ -44,6 +47,7 @@ private:
   std::unordered_map<lsn_t, int> lsn_mapping_;
   // log buffer related
   int offset_;
+  int log_buffer_size_;
   char *log_buffer_;
 };
 
@@ -10,14 +10,22 @@
  *
  * Internal page format (keys are stored in increasing order):
  *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ * | HEADER | OFFSET(0) | ... | OFFSET(n) | free space |
  *  --------------------------------------------------------------------------
+ *  --------------------------------------------------------------------------
+ * | PAGE_ID(n) + KEY(n) | ... | PAGE_ID(1) + KEY(1) | PAGE_ID(0) |
+ *  --------------------------------------------------------------------------
+ *
+ * Pair i is stored right below pair i - 1, starting at OFFSET(i). Keys are
+ * stored up to their last non-zero byte, and are separators as short as
+ * possible (see Separator), the first one not at all.
  */
 
 #pragma once
 
 #include <queue>
 #include <memory>
+#include <vector>
 #include "page/b_plus_tree_page.h"
 
 namespace cmudb {
@@ -30,43 +38,63 @@ class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  // bytes of an internal page for the offsets and the pairs
+  static int Capacity();
+  // bytes a pair takes at most, its offset included
+  static int MaxEntrySize();
 
   KeyType KeyAt(int index) const;
+  // whether key fits in place of the key at index
+  bool CanSetKeyAt(int index, const KeyType &key) const;
   void SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
+  int GetFreeSpace() const;
+  // less than half of the capacity is used
+  bool IsUnderfull() const;
+  bool CanInsert(const KeyType &key) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  // Lookup on a page read without latch, false if it is not consistent
+  bool LookupOptimistic(const KeyType &key, ValueType &value,
+                        const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
 		       const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                       const ValueType &new_value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
+  // add a child to the right of every other one, for bulk loading
+  void Append(const KeyType &key, const ValueType &value);
 
-  void MoveHalfTo(BPlusTreeInternalPage *recipient,
-                  BufferPoolManager *buffer_pool_manager);
+  KeyType InsertAndMoveHalfTo(const ValueType &old_value,
+                              const KeyType &new_key,
+                              const ValueType &new_value,
+                              BPlusTreeInternalPage *recipient,
+                              BufferPoolManager *buffer_pool_manager);
+  bool CanAbsorb(const BPlusTreeInternalPage *sibling,
+                 const KeyType &middle_key) const;
   void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
                  BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
-                         int parent_index,
-                         BufferPoolManager *buffer_pool_manager);
+  bool Redistribute(BPlusTreeInternalPage *sibling,
+                    BufferPoolManager *buffer_pool_manager);
   // DEUBG and PRINT
   std::string ToString(bool verbose) const;
   void QueueUpChildren(std::queue<BPlusTreePage *> *queue,
                        BufferPoolManager *buffer_pool_manager);
   bool CheckIntegrity(std::shared_ptr<KeyType> lower_bound, std::shared_ptr<KeyType> higher_bound, const KeyComparator &comparator, BufferPoolManager* buffer_pool_manager) const;
 private:
-  void CopyHalfFrom(MappingType *items, int size,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyAllFrom(MappingType *items, int size,
-                   BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, int parent_index,
-                     BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
+  // where to cut items in two pages taking about as many bytes, the key at
+  // the cut going to the parent
+  static int SplitIndex(const MappingType *items, int size);
+  int PairEnd(int index) const;
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  void GetItems(std::vector<MappingType> &items) const;
+  // replace every pair with the size ones at items
+  void CopyFrom(const MappingType *items, int size);
+  // become the parent of the children in [begin, end)
+  void Adopt(int begin, int end, BufferPoolManager *buffer_pool_manager);
+  uint16_t offsets_[0];
 };
 } // namespace cmudb
@@ -7,16 +7,25 @@
 
  * Leaf page format (keys are stored in order):
  *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ * | HEADER | OFFSET(1) | ... | OFFSET(n) | free space |
+ *  ----------------------------------------------------------------------
+ *  ----------------------------------------------------------------------
+ *  | RID(n) + SUFFIX(n) | ... | RID(1) + SUFFIX(1) | PREFIX |
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ * Every key of the page starts with PREFIX, which is stored once at the end
+ * of the page. Pair i is stored right below pair i - 1, starting at
+ * OFFSET(i): its RID, then its key without the prefix and without trailing
+ * zero bytes. Pairs take the space their keys need, so a page holds many
+ * more short or similar keys than its key type is wide.
+ *
+ *  Header format (size in byte, 30 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  -----------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | PrefixSize (2)
+ *  -----------------------------------------------------------------
  */
 #pragma once
 #include <utility>
@@ -36,40 +45,71 @@ public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  // bytes of a leaf page for the prefix, the offsets and the pairs
+  static int Capacity();
+  // bytes a pair takes at most, its offset included
+  static int MaxEntrySize();
+  // bytes count pairs take, sharing prefix_size bytes and the rest of their
+  // keys being suffix_size bytes together
+  static int SpaceFor(int count, int suffix_size, int prefix_size);
+  static int SpaceFor(const MappingType *begin, const MappingType *end);
+  // where to cut sorted items in two pages taking about as many bytes
+  static int SplitIndex(const MappingType *items, int size);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
+  int GetFreeSpace() const;
+  // less than half of the capacity is used
+  bool IsUnderfull() const;
 
   // insert and delete methods
+  // whether key fits, the prefix may have to get shorter for it
+  bool CanInsert(const KeyType &key) const;
   int Insert(const KeyType &key, const ValueType &value,
              const KeyComparator &comparator);
   bool Lookup(const KeyType &key, ValueType &value,
               const KeyComparator &comparator) const;
+  // Lookup on a page read without latch, false if it is not consistent
+  bool LookupOptimistic(const KeyType &key, ValueType &value, bool &found,
+                        const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key,
                             const KeyComparator &comparator);
+  // replace every pair with the size sorted ones at items
+  void CopyFrom(const MappingType *items, int size);
+
   // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient,
-                  BufferPoolManager *buffer_pool_manager /* Unused */);
+  KeyType InsertAndMoveHalfTo(const KeyType &key, const ValueType &value,
+                              BPlusTreeLeafPage *recipient,
+                              const KeyComparator &comparator);
+  bool CanAbsorb(const BPlusTreeLeafPage *sibling,
+                 const KeyType & /* Unused */) const;
   void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
                  BufferPoolManager *buffer_pool_manager);
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
-                         BufferPoolManager *buffer_pool_manager);
+  bool Redistribute(BPlusTreeLeafPage *sibling,
+                    BufferPoolManager *buffer_pool_manager);
   // Debug
   std::string ToString(bool verbose = false) const;
   bool CheckIntegrity(std::shared_ptr<KeyType> lower_bound, std::shared_ptr<KeyType> higher_bound, const KeyComparator &comparator, BufferPoolManager* buffer_pool_manager) const;
 
 private:
-  void CopyHalfFrom(MappingType *items, int size);
-  void CopyAllFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item, int parentIndex,
-                     BufferPoolManager *buffer_pool_manager);
+  // spaces[i] = bytes the first (or last, if reverse) i of the pairs at
+  // items take on a page
+  static void Spaces(const MappingType *items, int size, bool reverse,
+                     std::vector<int> &spaces);
+  // where the pairs end, the prefix is above
+  int PairsEnd() const;
+  int PairEnd(int index) const;
+  ValueType ValueAt(int index) const;
+  // bytes key shares with the prefix
+  int PrefixOf(const KeyType &key) const;
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  void GetItems(std::vector<MappingType> &items) const;
   page_id_t next_page_id_;
-  MappingType array[0];
+  uint16_t prefix_size_;
+  uint16_t offsets_[0];
 };
 } // namespace cmudb
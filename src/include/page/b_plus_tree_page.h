@@ -19,6 +19,7 @@
 #include <cassert>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <memory>
 
@@ -32,6 +33,74 @@ namespace cmudb {
 #define INDEX_TEMPLATE_ARGUMENTS                                               \
   template <typename KeyType, typename ValueType, typename KeyComparator>
 
+// searches within a page go linear below this many pairs
+#define LINEAR_SEARCH_SIZE 4
+
+/*
+ * Index of the first of the "size" pairs of "items" for which "before" is
+ * false, or size if there is none. "before" must hold for a prefix of the
+ * pairs only. Halves the range without branching on the outcome of "before"
+ * (a conditional move), so the search costs O(log size) calls of it plus a
+ * short linear tail
+ */
+template <typename Item, typename Predicate>
+inline int PartitionPoint(const Item *items, int size, Predicate before) {
+  const Item *base = items;
+  int n = size;
+  while (n > LINEAR_SEARCH_SIZE) {
+    int half = n / 2;
+    base = before(base[half]) ? base + half : base;
+    n -= half;
+  }
+  // the answer is within base[0] .. base[n]
+  while (n > 0 && before(*base)) {
+    base++;
+    n--;
+  }
+  return static_cast<int>(base - items);
+}
+
+/*
+ * Index keys are normalized (see GenericKey::SetFromKey), they compare as
+ * their bytes. Pages only store the bytes that tell keys apart: up to the
+ * last non-zero one, without the prefix the keys of a leaf share.
+ */
+// bytes of key up to its last non-zero one
+template <typename KeyType> inline int KeyLength(const KeyType &key) {
+  const char *data = reinterpret_cast<const char *>(&key);
+  int length = sizeof(KeyType);
+  while (length > 0 && data[length - 1] == 0) {
+    length--;
+  }
+  return length;
+}
+
+// bytes lhs and rhs start with
+template <typename KeyType>
+inline int CommonPrefix(const KeyType &lhs, const KeyType &rhs) {
+  const char *lhs_data = reinterpret_cast<const char *>(&lhs);
+  const char *rhs_data = reinterpret_cast<const char *>(&rhs);
+  int length = 0;
+  while (length < static_cast<int>(sizeof(KeyType)) &&
+         lhs_data[length] == rhs_data[length]) {
+    length++;
+  }
+  return length;
+}
+
+// shortest key larger than lhs and not larger than rhs (lhs < rhs): rhs cut
+// after the first byte that differs, to separate pages in their parent
+template <typename KeyType>
+inline KeyType Separator(const KeyType &lhs, const KeyType &rhs) {
+  KeyType separator = rhs;
+  int length = CommonPrefix(lhs, rhs) + 1;
+  if (length < static_cast<int>(sizeof(KeyType))) {
+    memset(reinterpret_cast<char *>(&separator) + length, 0,
+           sizeof(KeyType) - length);
+  }
+  return separator;
+}
+
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE, TRIVIAL_PAGE };
 
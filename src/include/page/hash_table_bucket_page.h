@@ -0,0 +1,62 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket of a disk resident extendible hash index. Stores unordered key and
+ * record id pairs, only unique keys. A bucket that can't split any more
+ * (the directory is full) chains overflow pages through NextPageId.
+ *
+ * Format (size in byte):
+ *  ----------------------------------------------------------------------
+ * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ *  ----------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 16 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | CurrentSize (4) | NextPageId (4) |
+ *  ---------------------------------------------------------------------
+ */
+#pragma once
+
+#include <utility>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+#define HASH_TABLE_BUCKET_PAGE_TYPE                                            \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+
+public:
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id);
+  // helper methods
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+  int GetSize() const;
+  int GetMaxSize() const;
+  bool IsFull() const;
+  bool IsEmpty() const;
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType KeyAt(int index) const;
+  const MappingType &GetItem(int index) const;
+
+  // lookup and modifier
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  // append, caller checks the key is new and the page not full
+  void Insert(const KeyType &key, const ValueType &value);
+  bool Remove(const KeyType &key, const KeyComparator &comparator);
+  void RemoveAt(int index);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int size_;
+  page_id_t next_page_id_;
+  MappingType array[0];
+};
+} // namespace cmudb
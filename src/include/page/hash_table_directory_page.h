@@ -0,0 +1,80 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Directory of a disk resident extendible hash index. Slot i holds the id of
+ * the bucket page covering every key whose hash ends with the low
+ * global_depth bits of i, and the local depth of that bucket. The page only
+ * has room for a fixed number of slots, which bounds the global depth.
+ *
+ * Format (size in byte):
+ *  --------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | BucketPageId (4) * N | Depth * N
+ *  --------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// largest power of two number of slots fitting in a page
+inline uint32_t DirectoryArraySize() {
+  uint32_t slots = 1;
+  while (12 + 2 * slots * (sizeof(page_id_t) + sizeof(uint8_t)) <=
+         static_cast<size_t>(PAGE_SIZE)) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+#define DIRECTORY_ARRAY_SIZE DirectoryArraySize()
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method to set default values
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  uint32_t GetGlobalDepth() const;
+  // mask selecting the low global depth bits of a hash
+  uint32_t GetGlobalDepthMask() const;
+  // number of slots in use, 2^global_depth
+  uint32_t Size() const;
+  bool CanGrow() const;
+  // every bucket is shallower than the directory
+  bool CanShrink() const;
+  // double the slots, the new upper half mirrors the lower half
+  void IncrGlobalDepth();
+  void DecrGlobalDepth();
+
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+  void SetLocalDepth(uint32_t bucket_idx, uint32_t local_depth);
+
+  // slot differing from bucket_idx in the top bit of its local depth: the
+  // image it was split from, and the one it merges back with
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_;
+  // DIRECTORY_ARRAY_SIZE bucket page ids, then as many local depths, the
+  // page size is only known at runtime
+  page_id_t bucket_page_ids_[0];
+
+  inline uint8_t *LocalDepths() const {
+    return reinterpret_cast<uint8_t *>(const_cast<page_id_t *>(
+        bucket_page_ids_ + DIRECTORY_ARRAY_SIZE));
+  }
+};
+
+} // namespace cmudb
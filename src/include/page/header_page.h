@@ -1,14 +1,25 @@
 /**
  * header_page.h
  *
- * Database use the first page (page_id = 0) as header page to store metadata, in
- * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * The first page of the database file (page_id = 0) identifies the file and
+ * records its page size, at offsets that do not depend on the page size:
+ *  --------------------------------
+ * | Magic (4) | PageSize (4) | ... |
+ *  --------------------------------
+ *
+ * Database use the second page (page_id = HEADER_PAGE_ID) as header page to
+ * store metadata, in our case, we will contain information about table/index
+ * name (length less than 32 bytes) and their corresponding root_id
  *
  * Format (size in byte):
  *  -----------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
  *  -----------------------------------------------------------------
+ *
+ * The last 8 bytes locate the last complete checkpoint in the log:
+ *  ---------------------------------------------------
+ * | ... | Checkpoint LSN (4) | Checkpoint log offset (4) |
+ *  ---------------------------------------------------
  */
 
 #pragma once
@@ -16,12 +27,26 @@
 #include "page/page.h"
 
 #include <cstring>
+#include <string>
 
 namespace cmudb {
 
+class FileHeaderPage : public Page {
+public:
+  void Init();
+  int GetPageSize();
+  // page size recorded at the start of db_file, read without a buffer pool
+  // since the pool needs it first. 0 if the database is empty, -1 if the file
+  // is not a database or records an invalid page size
+  static int ReadPageSize(const std::string &db_file);
+};
+
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  void Init() {
+    SetRecordCount(0);
+    SetCheckpoint(INVALID_LSN, 0);
+  }
   /**
    * Record related
    */
@@ -33,6 +58,13 @@ public:
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
 
+  /**
+   * Checkpoint related
+   */
+  void SetCheckpoint(lsn_t lsn, int log_offset);
+  lsn_t GetCheckpointLSN();
+  int GetCheckpointOffset();
+
 private:
   /**
    * helper functions
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <thread>
 #include <iostream>
@@ -21,7 +22,7 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
@@ -32,11 +33,16 @@ public:
   // method use to latch/unlatch page content
   inline void WUnlatch() {
     // std::cout << std::this_thread::get_id() << "WU" << std::endl;
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
     rwlatch_.WUnlock();
   }
   inline void WLatch() {
     // std::cout << std::this_thread::get_id() << "W" << std::endl;
     rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
   }
   inline void RUnlatch() {
     // std::cout << std::this_thread::get_id() << "RU" << std::endl;
@@ -46,6 +52,18 @@ public:
     // std::cout << std::this_thread::get_id() << "R" << std::endl;
     rwlatch_.RLock();
   }
+  inline bool TryRLatch() { return rwlatch_.TryRLock(); }
+  // optimistic readers take no latch: they read the version, read the
+  // content, then validate that the version didn't change meanwhile.
+  // ReadVersion returns false while a writer holds the latch
+  inline bool ReadVersion(uint64_t &version) {
+    version = version_.load(std::memory_order_acquire);
+    return (version & 1) == 0;
+  }
+  inline bool ValidateVersion(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
@@ -54,11 +72,23 @@ private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
+  // actual data, PAGE_SIZE bytes owned by the buffer pool
+  char *data_ = nullptr;
+  // read without any lock by optimistic readers, see
+  // BufferPoolManager::PeekPage. A frame only gets a page while write latched
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
   int pin_count_ = 0;
   bool is_dirty_ = false;
+  // true while the buffer pool is reading the page content from disk, the
+  // reader holds the write latch until the content is valid
+  std::atomic<bool> io_in_flight_{false};
+  // true while the background flusher is writing the page, which holds the
+  // read latch (but no pin) until the write completes
+  std::atomic<bool> write_back_in_flight_{false};
   RWMutex rwlatch_;
+  // odd while write latched, bumped on WLatch and on WUnlatch. The buffer
+  // pool write latches a frame to give it another page, so it changes then too
+  std::atomic<uint64_t> version_{0};
 };
 
 } // namespace cmudb
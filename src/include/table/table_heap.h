@@ -60,6 +60,8 @@ private:
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_;
+  // new pages come from it, so that a scan reads the file sequentially
+  Extent extent_;
 };
 
 } // namespace cmudb
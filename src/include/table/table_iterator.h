@@ -2,11 +2,17 @@
  * table_iterator.h
  *
  * For seq scan of table heap
+ *
+ * The iterator reads ahead: it keeps the next pages of the heap page chain
+ * in flight, so a scan doesn't wait for every page miss one after another.
+ * The chain is only known as far as the pages already loaded, the window
+ * grows as they arrive.
  */
 
 #pragma once
 
 #include <cassert>
+#include <deque>
 
 #include "common/rid.h"
 #include "table/tuple.h"
@@ -40,9 +46,13 @@ public:
   TableIterator operator++(int);
 
 private:
+  void ReadAhead(page_id_t page_id, page_id_t next_page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // pages being read ahead, in chain order after the current page
+  std::deque<page_id_t> read_ahead_;
 };
 
 } // namespace cmudb
\ No newline at end of file
@@ -4,11 +4,19 @@
 
 #pragma once
 
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+
 #include "buffer/lru_replacer.h"
 #include "catalog/schema.h"
+#include "common/exception.h"
+#include "common/logger.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
+#include "index/hash_index.h"
 #include "logging/log_manager.h"
+#include "page/header_page.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -65,6 +73,42 @@ public:
   StorageEngine(std::string db_file_name) {
     ENABLE_LOGGING = false;
 
+    // an existing database keeps the page size it was created with, a new one
+    // takes CMUDB_PAGE_SIZE. The pool size is picked at every load, from
+    // CMUDB_BUFFER_POOL_SIZE
+    PAGE_SIZE = FileHeaderPage::ReadPageSize(db_file_name);
+    if (PAGE_SIZE == -1) {
+      throw Exception(EXCEPTION_TYPE_INVALID,
+                      db_file_name + " is not a database or is corrupted");
+    }
+    bool is_new_database = (PAGE_SIZE == 0);
+    if (is_new_database) {
+      PAGE_SIZE = GetEnvSize("CMUDB_PAGE_SIZE", DEFAULT_PAGE_SIZE,
+                             MIN_PAGE_SIZE, MAX_PAGE_SIZE);
+      if ((PAGE_SIZE & (PAGE_SIZE - 1)) != 0) {
+        LOG_DEBUG("invalid page size %d, using %d", PAGE_SIZE,
+                  DEFAULT_PAGE_SIZE);
+        PAGE_SIZE = DEFAULT_PAGE_SIZE;
+      }
+    }
+    // the pool must stay addressable in bytes
+    BUFFER_POOL_SIZE =
+        GetEnvSize("CMUDB_BUFFER_POOL_SIZE", DEFAULT_BUFFER_POOL_SIZE, 1,
+                   std::numeric_limits<int>::max() / PAGE_SIZE);
+    // CMUDB_NUMA_POLICY is "interleave" or "bind" (to CMUDB_NUMA_NODE), the
+    // frames stay local otherwise
+    const char *numa_policy = getenv("CMUDB_NUMA_POLICY");
+    BUFFER_POOL_NUMA_POLICY = NumaPolicy::LOCAL;
+    if (numa_policy != nullptr && std::string(numa_policy) == "interleave") {
+      BUFFER_POOL_NUMA_POLICY = NumaPolicy::INTERLEAVE;
+    } else if (numa_policy != nullptr && std::string(numa_policy) == "bind") {
+      BUFFER_POOL_NUMA_POLICY = NumaPolicy::BIND;
+    }
+    BUFFER_POOL_NUMA_NODE = GetEnvSize("CMUDB_NUMA_NODE", 0, 0,
+                                       std::numeric_limits<int>::max());
+    BUFFER_POOL_PREFAULT =
+        GetEnvSize("CMUDB_BUFFER_POOL_PREFAULT", 0, 0, 1) != 0;
+
     // storage related
     disk_manager_ = new DiskManager(db_file_name);
 
@@ -77,6 +121,10 @@ public:
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
+
+    if (is_new_database) {
+      CreateHeaderPages();
+    }
   }
 
   ~StorageEngine() {
@@ -94,6 +142,49 @@ public:
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
+
+private:
+  // the file header and the header page of a new database, which must reach
+  // the disk before anything else
+  void CreateHeaderPages() {
+    page_id_t page_id;
+    auto *file_header_page = static_cast<FileHeaderPage *>(
+        buffer_pool_manager_->NewPage(page_id));
+    if (file_header_page == nullptr || page_id != FILE_HEADER_PAGE_ID) {
+      throw Exception(EXCEPTION_TYPE_INVALID, "can't create the file header");
+    }
+    file_header_page->Init();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    buffer_pool_manager_->FlushPage(page_id);
+
+    auto *header_page =
+        static_cast<HeaderPage *>(buffer_pool_manager_->NewPage(page_id));
+    if (header_page == nullptr || page_id != HEADER_PAGE_ID) {
+      throw Exception(EXCEPTION_TYPE_INVALID, "can't create the header page");
+    }
+    header_page->Init();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    buffer_pool_manager_->FlushPage(page_id);
+  }
+
+  // value of the environment variable name, or default_value if it is unset
+  // or not an integer in [min_value, max_value]
+  static int GetEnvSize(const char *name, int default_value, int min_value,
+                        int max_value) {
+    const char *value = getenv(name);
+    if (value == nullptr) {
+      return default_value;
+    }
+    char *end;
+    errno = 0;
+    long size = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || errno == ERANGE || size < min_value ||
+        size > max_value) {
+      LOG_DEBUG("invalid %s \"%s\", using %d", name, value, default_value);
+      return default_value;
+    }
+    return static_cast<int>(size);
+  }
 };
 
 StorageEngine *storage_engine_;
@@ -145,6 +236,28 @@ public:
     index_->InsertEntry(key, rid, GetTransaction());
   }
 
+  // fill the empty index from the tuples already in the table heap, built
+  // bottom-up in one go rather than one insert at a time
+  void BuildIndex() {
+    if (index_ == nullptr)
+      return;
+    Transaction *txn = storage_engine_->transaction_manager_->Begin();
+    std::vector<std::pair<Tuple, RID>> entries;
+    for (auto iter = table_heap_->begin(txn); iter != table_heap_->end();
+         ++iter) {
+      // construct indexed key tuple
+      std::vector<Value> key_values;
+
+      for (auto &i : index_->GetKeyAttrs())
+        key_values.push_back(iter->GetValue(schema_, i));
+      entries.emplace_back(Tuple(key_values, index_->GetKeySchema()),
+                           iter->GetRid());
+    }
+    if (!entries.empty())
+      index_->BulkLoad(entries, txn);
+    storage_engine_->transaction_manager_->Commit(txn);
+  }
+
   // delete from table heap
   // TODO: call makrdelete method from heaptable
   inline bool DeleteTuple(const RID &rid) {
@@ -1,6 +1,7 @@
 /**
  * b_plus_tree.cpp
  */
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <queue>
@@ -33,12 +34,20 @@ BPLUSTREE_TYPE::BPlusTree(const std::string &name,
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::IsEmpty() const {
-  if (root_page_id_ == INVALID_PAGE_ID) {
-	return true;
+  // the root can't change nor go away while the trivial page is latched
+  Page *trivial_page = buffer_pool_manager_->FetchPage(trivial_page_id_);
+  trivial_page->RLatch();
+  page_id_t root_page_id = root_page_id_;
+  bool isEmpty = true;
+  if (root_page_id != INVALID_PAGE_ID) {
+	Page *page = buffer_pool_manager_->FetchPage(root_page_id);
+	page->RLatch();
+	isEmpty = reinterpret_cast<BPlusTreePage *>(page->GetData())->GetSize() == 0;
+	page->RUnlatch();
+	buffer_pool_manager_->UnpinPage(root_page_id, false);
   }
-  auto page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
-  bool isEmpty = page->GetSize() == 0;
-  buffer_pool_manager_->UnpinPage(root_page_id_, false);
+  trivial_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(trivial_page_id_, false);
   return isEmpty;
 }
 
@@ -78,25 +87,85 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
 							  std::vector<ValueType> &result,
 							  Transaction *transaction) {
-
-  Page *page = FindLeafPage(key, false, transaction, BPlusTreeActionType::LookUp);
-
-  auto leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
-
   ValueType value;
-  if (leaf_page->Lookup(key, value, comparator_)) {
-	result.push_back(value);
+  bool found = false;
+  if (!GetValueOptimistic(key, value, found)) {
+	// a page has to be read from disk, or writers kept getting in the way
+	Page *page = FindLeafPage(key, false, transaction, BPlusTreeActionType::LookUp);
+	auto leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+	found = leaf_page->Lookup(key, value, comparator_);
 	page->RUnlatch();
 	if (transaction)
 	  transaction->GetPageSet()->pop_front();
 	buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-	return true;
   }
 
-  page->RUnlatch();
-  if (transaction)
-	transaction->GetPageSet()->pop_front();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+  if (found) {
+	result.push_back(value);
+  }
+  return found;
+}
+
+/*
+ * Point lookup without latching nor pinning any page (optimistic lock
+ * coupling). Pages are read in place, where they are in the buffer pool, and
+ * what is read from a page only used once the version of its frame is
+ * validated. Once the version of the child is read, the version of the parent
+ * is validated again, so that the child is still the one to go to. Any change
+ * restarts the lookup from the root.
+ * @return : false if the lookup didn't get through within
+ * OPTIMISTIC_LOOKUP_ATTEMPTS attempts, or a page is not in the buffer pool;
+ * otherwise found tells whether key exists, and value is its value
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::GetValueOptimistic(const KeyType &key, ValueType &value,
+										bool &found) {
+  for (int attempt = 0; attempt < OPTIMISTIC_LOOKUP_ATTEMPTS; attempt++) {
+	// the trivial page is write latched while the root changes
+	Page *page = buffer_pool_manager_->PeekPage(trivial_page_id_);
+	if (page == nullptr) {
+	  return false;
+	}
+	uint64_t version;
+	bool valid = page->ReadVersion(version) &&
+				 page->GetPageId() == trivial_page_id_;
+	page_id_t page_id = root_page_id_;
+	if (valid && page_id == INVALID_PAGE_ID) {
+	  if (page->ValidateVersion(version)) {
+		found = false;
+		return true;
+	  }
+	  continue;
+	}
+
+	while (valid) {
+	  Page *child = buffer_pool_manager_->PeekPage(page_id);
+	  if (child == nullptr) {
+		return false;
+	  }
+	  uint64_t child_version;
+	  valid = child->ReadVersion(child_version) &&
+			  child->GetPageId() == page_id && page->ValidateVersion(version);
+	  page = child;
+	  version = child_version;
+	  if (!valid) {
+		break;
+	  }
+
+	  auto bpage = reinterpret_cast<BPlusTreePage *>(page->GetData());
+	  if (bpage->IsLeafPage()) {
+		auto leaf_page = static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(bpage);
+		if (leaf_page->LookupOptimistic(key, value, found, comparator_) &&
+			page->ValidateVersion(version)) {
+		  return true;
+		}
+		break;
+	  }
+	  auto internal_page = static_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(bpage);
+	  valid = internal_page->LookupOptimistic(key, page_id, comparator_) &&
+			  page->ValidateVersion(version);
+	}
+  }
   return false;
 }
 
@@ -137,15 +206,21 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
   page_id_t page_id;
-  auto page = buffer_pool_manager_->NewPage(page_id)->GetData();
+  auto page = buffer_pool_manager_->NewPage(page_id, &extent_)->GetData();
   if (page == nullptr) {
 	throw "out of memory";
   }
-  root_page_id_ = page_id;
-  UpdateRootPageId();
   auto leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page);
   leaf_page->Init(page_id, INVALID_PAGE_ID);
   leaf_page->Insert(key, value, comparator_);
+  // lookups find the page from now on. Like any root change, under the write
+  // latch of the trivial page, which optimistic lookups validate
+  Page *trivial_page = buffer_pool_manager_->FetchPage(trivial_page_id_);
+  trivial_page->WLatch();
+  root_page_id_ = page_id;
+  trivial_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(trivial_page_id_, false);
+  UpdateRootPageId();
   buffer_pool_manager_->UnpinPage(page_id, true);
 }
 
@@ -174,18 +249,13 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 	return false;
   }
 
-  if (leaf_page->GetSize() + 1 > leaf_page->GetMaxSize()) {
+  if (leaf_page->CanInsert(key)) {
+	leaf_page->Insert(key, value, comparator_);
+  } else {
 	auto new_page = Split(leaf_page);
-	auto pop_key = new_page->KeyAt(0);
-	if (comparator_(key, pop_key) < 0) {
-	  leaf_page->Insert(key, value, comparator_);
-	} else {
-	  new_page->Insert(key, value, comparator_);
-	}
-	InsertIntoParent(leaf_page, pop_key, new_page, transaction);
+	auto separator = leaf_page->InsertAndMoveHalfTo(key, value, new_page, comparator_);
+	InsertIntoParent(leaf_page, separator, new_page, transaction);
 	buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
-  } else {
-	leaf_page->Insert(key, value, comparator_);
   }
 
   ReleasePageSet(transaction, BPlusTreeActionType::Insert, true);
@@ -193,28 +263,23 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 }
 
 /*
- * Split input page and return newly created page.
- * Using template N to represent either internal page or leaf page.
+ * Create the page a split of input page moves its upper pairs to, and return
+ * it. Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * an "out of memory" exception if returned value is nullptr). The pages being
+ * split by bytes, the caller moves the pairs along with the one it inserts
+ * (InsertAndMoveHalfTo)
  */
 INDEX_TEMPLATE_ARGUMENTS
 template<typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
   page_id_t new_page_id;
-  auto new_page = reinterpret_cast<N *>(buffer_pool_manager_->NewPage(new_page_id)->GetData());
-  new_page->Init(new_page_id, node->GetParentPageId());
-  if (new_page == nullptr) {
+  Page *page = buffer_pool_manager_->NewPage(new_page_id, &extent_);
+  if (page == nullptr) {
 	throw "out of memory";
   }
-
-  node->MoveHalfTo(new_page, buffer_pool_manager_);
-
-  // This api seems awkward to me
-  // TODO
-  // should I do this
-  // buffer_pool_manager_->UnpinPage(new_page_id, true);
+  auto new_page = reinterpret_cast<N *>(page->GetData());
+  new_page->Init(new_page_id, node->GetParentPageId());
   return new_page;
 }
 
@@ -238,7 +303,7 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
 	// populate the new root if the root page is overflow
 	auto parent_page =
 		reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(buffer_pool_manager_->NewPage(
-			parent_page_id)->GetData());
+			parent_page_id, &extent_)->GetData());
 	if (parent_page == nullptr)
 	  throw "out of memory";
 	parent_page->Init(parent_page_id, INVALID_PAGE_ID);
@@ -252,18 +317,11 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
 		reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(buffer_pool_manager_->FetchPage(
 			parent_page_id)->GetData());
 
-	if (parent_page->GetSize() + 1 > parent_page->GetMaxSize()) {
+	if (!parent_page->CanInsert(key)) {
 	  // if the parent page is overflow, we should recursively split
 	  auto new_page = Split(parent_page);
-	  // important and beautiful idea
-	  auto pop_key = new_page->KeyAt(0);
-	  if (comparator_(key, pop_key) < 0) {
-		parent_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-		new_node->SetParentPageId(parent_page->GetPageId());
-	  } else {
-		new_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-		new_node->SetParentPageId(new_page->GetPageId());
-	  }
+	  auto pop_key = parent_page->InsertAndMoveHalfTo(old_node->GetPageId(), key, new_node->GetPageId(),
+													  new_page, buffer_pool_manager_);
 	  InsertIntoParent(parent_page, pop_key, new_page, transaction);
 	  buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
 	} else {
@@ -275,6 +333,246 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
   buffer_pool_manager_->UnpinPage(parent_page_id, true);
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build an empty tree bottom-up from the pairs returned by "next" (false once
+ * there is none left), which must come in ascending key order. Leaves are
+ * filled left to right, fill_factor (between 0.5 and 1) of their capacity
+ * each, and linked in the order they are written. Only the key and the page
+ * id of every leaf are kept in memory, the internal levels are built from
+ * them once all the leaves are on their pages.
+ * @return: false if the tree isn't empty, or a key isn't larger than the
+ * previous one (the tree is left empty)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(
+	const std::function<bool(KeyType &, ValueType &)> &next,
+	double fill_factor) {
+  std::lock_guard<std::mutex> latch(root_id_latch_);
+  if (root_page_id_ != INVALID_PAGE_ID) {
+	return false;
+  }
+  fill_factor = std::min(1.0, std::max(0.5, fill_factor));
+  int leaf_space = std::max(B_PLUS_TREE_LEAF_PAGE_TYPE::MaxEntrySize(), static_cast<int>(
+	  fill_factor * B_PLUS_TREE_LEAF_PAGE_TYPE::Capacity()));
+
+  // a leaf is only written once the next one is full, so that the last two
+  // can share what is left and stay at least half full
+  std::vector<MappingType> pending, current;
+  std::vector<std::pair<KeyType, page_id_t>> children;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *prev_leaf = nullptr;
+  KeyType key;
+  ValueType value;
+  bool ordered = true;
+  // bytes the keys of current share, and the bytes of the rest of them
+  int prefix_size = sizeof(KeyType);
+  int suffix_size = 0;
+  while (next(key, value)) {
+	// current only starts empty
+	if (!current.empty() && comparator_(current.back().first, key) >= 0) {
+	  ordered = false;
+	  break;
+	}
+	int new_prefix_size = current.empty() ? prefix_size : CommonPrefix(current[0].first, key);
+	if (new_prefix_size < prefix_size) {
+	  suffix_size = 0;
+	  for (auto &item : current) {
+		suffix_size += std::max(0, KeyLength(item.first) - new_prefix_size);
+	  }
+	}
+	int new_suffix_size = suffix_size + std::max(0, KeyLength(key) - new_prefix_size);
+	if (!current.empty() &&
+		B_PLUS_TREE_LEAF_PAGE_TYPE::SpaceFor(static_cast<int>(current.size()) + 1, new_suffix_size,
+											 new_prefix_size) > leaf_space) {
+	  if (!pending.empty()) {
+		WriteLeaf(pending, prev_leaf, children);
+	  }
+	  pending.swap(current);
+	  current.clear();
+	  new_prefix_size = sizeof(KeyType);
+	  new_suffix_size = 0;
+	}
+	current.emplace_back(key, value);
+	prefix_size = new_prefix_size;
+	suffix_size = new_suffix_size;
+  }
+
+  if (!ordered) {
+	if (prev_leaf != nullptr) {
+	  buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), false);
+	}
+	for (auto &child : children) {
+	  buffer_pool_manager_->DeletePage(child.second);
+	}
+	return false;
+  }
+  int capacity = B_PLUS_TREE_LEAF_PAGE_TYPE::Capacity();
+  if (!pending.empty() &&
+	  B_PLUS_TREE_LEAF_PAGE_TYPE::SpaceFor(current.data(), current.data() + current.size()) < capacity / 2) {
+	pending.insert(pending.end(), current.begin(), current.end());
+	current.clear();
+	if (B_PLUS_TREE_LEAF_PAGE_TYPE::SpaceFor(pending.data(), pending.data() + pending.size()) > capacity) {
+	  int middle = B_PLUS_TREE_LEAF_PAGE_TYPE::SplitIndex(pending.data(), static_cast<int>(pending.size()));
+	  current.assign(pending.begin() + middle, pending.end());
+	  pending.resize(middle);
+	}
+  }
+  if (!pending.empty()) {
+	WriteLeaf(pending, prev_leaf, children);
+  }
+  if (!current.empty()) {
+	WriteLeaf(current, prev_leaf, children);
+  }
+  if (prev_leaf != nullptr) {
+	buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+  }
+  if (children.empty()) {
+	return true;
+  }
+
+  while (children.size() > 1) {
+	BuildInternalLevel(children, fill_factor);
+  }
+  // as in StartNewTree, the root is published under the trivial page latch
+  Page *trivial_page = buffer_pool_manager_->FetchPage(trivial_page_id_);
+  trivial_page->WLatch();
+  root_page_id_ = children[0].second;
+  trivial_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(trivial_page_id_, false);
+  UpdateRootPageId();
+  return true;
+}
+
+/*
+ * Build the tree from pairs in any order: sorted in memory first, then
+ * loaded as above
+ * @return: false if the tree isn't empty or two pairs have the same key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(std::vector<MappingType> &items,
+							  double fill_factor) {
+  std::sort(items.begin(), items.end(),
+			[this](const MappingType &a, const MappingType &b) {
+			  return comparator_(a.first, b.first) < 0;
+			});
+  size_t i = 0;
+  return BulkLoad(
+	  [&items, &i](KeyType &key, ValueType &value) {
+		if (i == items.size()) {
+		  return false;
+		}
+		key = items[i].first;
+		value = items[i].second;
+		i++;
+		return true;
+	  },
+	  fill_factor);
+}
+
+/*
+ * Write items on a new leaf from the extent and link prev_leaf to it. The new
+ * leaf stays pinned as the next prev_leaf, prev_leaf is unpinned. The shortest
+ * key separating it from prev_leaf and its page id go to the level above
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::WriteLeaf(
+	const std::vector<MappingType> &items,
+	B_PLUS_TREE_LEAF_PAGE_TYPE *&prev_leaf,
+	std::vector<std::pair<KeyType, page_id_t>> &children) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id, &extent_);
+  if (page == nullptr) {
+	throw "out of memory";
+  }
+  auto leaf_page = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  leaf_page->Init(page_id, INVALID_PAGE_ID);
+  leaf_page->CopyFrom(items.data(), static_cast<int>(items.size()));
+  KeyType separator = items[0].first;
+  if (prev_leaf != nullptr) {
+	separator = Separator(prev_leaf->KeyAt(prev_leaf->GetSize() - 1), separator);
+	prev_leaf->SetNextPageId(page_id);
+	buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+  }
+  prev_leaf = leaf_page;
+  children.emplace_back(separator, page_id);
+}
+
+/*
+ * Build the internal pages above "children" (the separator key and the page
+ * id of every page of one level, left to right), and replace them with the
+ * pages built. Pages are filled up to fill_factor of their bytes, the last
+ * two share what is left if the last one would be less than half full
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BuildInternalLevel(
+	std::vector<std::pair<KeyType, page_id_t>> &children, double fill_factor) {
+  typedef BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> InternalPage;
+  int capacity = InternalPage::Capacity();
+  int target = std::max(2 * InternalPage::MaxEntrySize(), static_cast<int>(fill_factor * capacity));
+  // the first child of a page has no key
+  const int pair_size = sizeof(uint16_t) + sizeof(page_id_t);
+  auto entry_size = [&](size_t i) { return pair_size + KeyLength(children[i].first); };
+
+  // where the children of every page end
+  std::vector<size_t> ends;
+  int space = 0;
+  for (size_t i = 0; i < children.size(); i++) {
+	if (space > 0 && space + entry_size(i) > target) {
+	  ends.push_back(i);
+	  space = 0;
+	}
+	space += space == 0 ? pair_size : entry_size(i);
+  }
+  ends.push_back(children.size());
+  if (ends.size() > 1 && space < capacity / 2) {
+	size_t begin = ends.size() > 2 ? ends[ends.size() - 3] : 0;
+	int total = pair_size;
+	for (size_t i = begin + 1; i < children.size(); i++) {
+	  total += entry_size(i);
+	}
+	if (total <= capacity) {
+	  ends.erase(ends.end() - 2);
+	} else {
+	  // cut where the fuller page takes the fewest bytes
+	  int first = pair_size;
+	  int best = total;
+	  for (size_t i = begin + 1; i < children.size(); i++) {
+		int last = total - first - entry_size(i) + pair_size;
+		if (std::max(first, last) < best) {
+		  best = std::max(first, last);
+		  ends[ends.size() - 2] = i;
+		}
+		first += entry_size(i);
+	  }
+	}
+  }
+
+  std::vector<std::pair<KeyType, page_id_t>> parents;
+  size_t begin = 0;
+  for (size_t end : ends) {
+	page_id_t page_id;
+	Page *page = buffer_pool_manager_->NewPage(page_id, &extent_);
+	if (page == nullptr) {
+	  throw "out of memory";
+	}
+	auto internal_page = reinterpret_cast<InternalPage *>(page->GetData());
+	internal_page->Init(page_id, INVALID_PAGE_ID);
+	for (size_t j = begin; j < end; j++) {
+	  internal_page->Append(children[j].first, children[j].second);
+	  auto child = reinterpret_cast<BPlusTreePage *>(
+		  buffer_pool_manager_->FetchPage(children[j].second)->GetData());
+	  child->SetParentPageId(page_id);
+	  buffer_pool_manager_->UnpinPage(children[j].second, true);
+	}
+	parents.emplace_back(children[begin].first, page_id);
+	buffer_pool_manager_->UnpinPage(page_id, true);
+	begin = end;
+  }
+  children.swap(parents);
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -315,7 +613,7 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
   }
 
   bool ok = false;
-  if (leaf_page->GetSize() < leaf_page->GetMinSize()) {
+  if (leaf_page->IsUnderfull()) {
 	ok = CoalesceOrRedistribute(leaf_page, transaction);
   }
   if (!transaction)
@@ -333,8 +631,10 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
 }
 
 /*
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
+ * User needs to first find the sibling of input page. If input page's pairs
+ * fit in a sibling page (or the other way round), then merge. Otherwise,
+ * redistribute; if that is not possible either (the new separator doesn't fit
+ * in the parent), the page stays less than half full.
  * Using template N to represent either internal page or leaf page.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
@@ -344,7 +644,7 @@ template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   page_id_t parent_page_id = node->GetParentPageId();
   assert(parent_page_id != INVALID_PAGE_ID);
-  if (node->GetSize() >= node->GetMinSize()) {
+  if (!node->IsUnderfull()) {
 	return false;
   }
 
@@ -352,48 +652,32 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
 
   int node_index = parent_page->ValueIndex(node->GetPageId());
   N *left_sibling_page = nullptr, *right_sibling_page = nullptr;
+  Page *left_page = nullptr, *right_page = nullptr;
 
+  // a writer which found its page safe latches nothing but that page, so the
+  // siblings are latched even though we hold their parent
   if (node_index-1 >= 0) {
-	page_id_t left_sibling_page_id = parent_page->ValueAt(node_index - 1);
-	left_sibling_page = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(left_sibling_page_id)->GetData());
-
-	// because we already delete the one, so we can merge it when sum size is maxsize
-	if (left_sibling_page->GetSize() + node->GetSize() >= node->GetMaxSize()) {
-	  // move from the left sibling page to the node so the index is
-	  // not zero
-	  Redistribute(left_sibling_page, node, 1);
-	  buffer_pool_manager_->UnpinPage(left_sibling_page->GetPageId(), true);
-	  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-	  return false;
-	}
+	left_page = buffer_pool_manager_->FetchPage(parent_page->ValueAt(node_index - 1));
+	left_page->WLatch();
+	left_sibling_page = reinterpret_cast<N *>(left_page->GetData());
   }
-
-  // because we already delete the one, so we can merge it when sum size is maxsize
   if (node_index+1 < parent_page->GetSize()) {
-	page_id_t right_sibling_page_id = parent_page->ValueAt(node_index + 1);
-	right_sibling_page = reinterpret_cast<N *>(buffer_pool_manager_->FetchPage(right_sibling_page_id)->GetData());
-	if (right_sibling_page->GetSize() + node->GetSize() >= node->GetMaxSize()) {
-	  // move from the right sibling page to the node so the index is
-	  // zero
-	  Redistribute(right_sibling_page, node, 0);
-	  if (left_sibling_page != nullptr) {
-		buffer_pool_manager_->UnpinPage(left_sibling_page->GetPageId(), true);
-	  }
-	  buffer_pool_manager_->UnpinPage(right_sibling_page->GetPageId(), true);
-	  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-	  return false;
-	}
+	right_page = buffer_pool_manager_->FetchPage(parent_page->ValueAt(node_index + 1));
+	right_page->WLatch();
+	right_sibling_page = reinterpret_cast<N *>(right_page->GetData());
   }
 
-  bool ok;
-  bool delete_node;
+  bool ok = false;
+  bool delete_node = false;
 
-  if (node_index - 1 >= 0) {
+  if (left_sibling_page != nullptr &&
+	  left_sibling_page->CanAbsorb(node, parent_page->KeyAt(node_index))) {
 	ok = Coalesce(left_sibling_page, node, parent_page, node_index, transaction);
 	delete_node = true;
-  } else {
-	ok = Coalesce(node, right_sibling_page, parent_page, node_index, transaction);
-	delete_node = false;
+  } else if (right_sibling_page != nullptr &&
+			 node->CanAbsorb(right_sibling_page, parent_page->KeyAt(node_index + 1))) {
+	ok = Coalesce(node, right_sibling_page, parent_page, node_index + 1, transaction);
+	right_page->WUnlatch();
 	buffer_pool_manager_->UnpinPage(right_sibling_page->GetPageId(), true);
 	if (transaction)
 	  transaction->GetDeletedPageSet()->insert(right_sibling_page->GetPageId());
@@ -401,15 +685,21 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
 	  assert(buffer_pool_manager_->DeletePage(right_sibling_page->GetPageId()));
 	}
 	right_sibling_page = nullptr;
+  } else if (left_sibling_page == nullptr || !Redistribute(left_sibling_page, node, 1)) {
+	if (right_sibling_page != nullptr) {
+	  Redistribute(right_sibling_page, node, 0);
+	}
   }
 
   // TODO(Handora): optimization
   // may be left or right or parent not changed
   if (left_sibling_page != nullptr) {
+	left_page->WUnlatch();
 	buffer_pool_manager_->UnpinPage(left_sibling_page->GetPageId(), true);
   }
 
   if (right_sibling_page != nullptr) {
+	right_page->WUnlatch();
 	buffer_pool_manager_->UnpinPage(right_sibling_page->GetPageId(), true);
   }
 
@@ -449,30 +739,28 @@ bool BPLUSTREE_TYPE::Coalesce(
   if (parent->IsRootPage()) {
 	return AdjustRoot(parent);
   }
-  if (parent->GetSize() < parent->GetMinSize())
+  if (parent->IsUnderfull())
 	return CoalesceOrRedistribute(parent, transaction);
   else
 	return false;
 }
 
 /*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * Redistribute key & value pairs between one page and its sibling page, so
+ * that both take about as many bytes. If index == 0, the sibling page is the
+ * next one of input "node", otherwise the previous one.
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @return  false means nothing moved
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+bool BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
   if (index == 0) {
-	neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
-  } else {
-	// the second parameter seems no use
-	neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
+	return node->Redistribute(neighbor_node, buffer_pool_manager_);
   }
+  return neighbor_node->Redistribute(node, buffer_pool_manager_);
 }
 /*
  * Update root page if necessary
@@ -497,7 +785,7 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
 	  auto internal_page = static_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(old_root_node);
 	  root_page_id_ = internal_page->ValueAt(0);
 	  // refresh the new root page to become the new parent.
-	  auto new_root_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_));
+	  auto new_root_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
 	  new_root_page->SetParentPageId(INVALID_PAGE_ID);
 	  buffer_pool_manager_->UnpinPage(root_page_id_, true);
 	}
@@ -557,6 +845,13 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 								   bool leftMost,
 								   Transaction *txn,
 								   BPlusTreeActionType type) {
+  // most writes change the leaf only, try that before latching the path
+  if (type != BPlusTreeActionType::LookUp) {
+	Page *leaf = FindLeafPageOptimistic(key, txn, type);
+	if (leaf != nullptr) {
+	  return leaf;
+	}
+  }
 
   Page *page = buffer_pool_manager_->FetchPage(trivial_page_id_);
 
@@ -596,7 +891,7 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 		auto new_page = buffer_pool_manager_->FetchPage(root_page_id);
 		new_page->WLatch();
 		bpage = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
-		if (bpage->GetSize() < bpage->GetMaxSize()) {
+		if (IsSafe(bpage, key, type)) {
 		  auto release_page = txn->GetPageSet()->front();
 		  release_page->WUnlatch();
 		  txn->GetPageSet()->pop_front();
@@ -611,7 +906,7 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 		auto new_page = buffer_pool_manager_->FetchPage(root_page_id);
 		new_page->WLatch();
 		bpage = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
-		if (bpage->GetSize() > 1) {
+		if (IsSafe(bpage, key, type)) {
 		  auto release_page = txn->GetPageSet()->front();
 		  release_page->WUnlatch();
 		  txn->GetPageSet()->pop_front();
@@ -649,7 +944,7 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 		auto new_page = buffer_pool_manager_->FetchPage(page_id);
 		new_page->WLatch();
 		bpage = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
-		if (bpage->GetSize() < bpage->GetMaxSize()) {
+		if (IsSafe(bpage, key, type)) {
 		  unsigned long size = txn->GetPageSet()->size();
 		  for (unsigned long i = 0; i < size; i++) {
 			auto release_page = txn->GetPageSet()->front();
@@ -668,7 +963,7 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
 		auto new_page = buffer_pool_manager_->FetchPage(page_id);
 		new_page->WLatch();
 		bpage = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
-		if (bpage->GetSize() > bpage->GetMinSize()) {
+		if (IsSafe(bpage, key, type)) {
 		  unsigned long size = txn->GetPageSet()->size();
 		  for (unsigned long i = 0; i < size; i++) {
 			auto release_page = txn->GetPageSet()->front();
@@ -689,6 +984,86 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
   return page;
 }
 
+/*
+ * Find the leaf page key is to be inserted into or deleted from, holding read
+ * latches on the way down and a write latch on the leaf only. The ancestors
+ * are released at once, so writers only share read latches on the upper
+ * levels.
+ * @return : the leaf, added to the page set of txn, or nullptr (nothing
+ * latched nor pinned) if the write may reach the parent, and has to crab
+ * down with write latches instead
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key,
+											 Transaction *txn,
+											 BPlusTreeActionType type) {
+  assert(txn != nullptr);
+  Page *page = buffer_pool_manager_->FetchPage(trivial_page_id_);
+  assert(page);
+  page->RLatch();
+  page_id_t page_id = root_page_id_;
+
+  while (true) {
+	auto new_page = buffer_pool_manager_->FetchPage(page_id);
+	assert(new_page != nullptr);
+	auto bpage = reinterpret_cast<BPlusTreePage *>(new_page->GetData());
+	// safe to read before latching: a page only becomes another kind of page
+	// after being deleted, which takes the write latch on the parent we hold
+	bool is_leaf = bpage->IsLeafPage();
+	if (is_leaf) {
+	  new_page->WLatch();
+	} else {
+	  new_page->RLatch();
+	}
+	page->RUnlatch();
+	buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+	page = new_page;
+	if (is_leaf) {
+	  if (!IsSafe(bpage, key, type)) {
+		page->WUnlatch();
+		buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+		return nullptr;
+	  }
+	  txn->AddIntoPageSet(page);
+	  return page;
+	}
+	auto internal_page = static_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(bpage);
+	page_id = internal_page->Lookup(key, comparator_);
+  }
+}
+
+/*
+ * Whether inserting or deleting key below node can't change its parent:
+ * node takes one more pair without a split, or loses one without becoming
+ * less than half full. A root is safe for a delete if it doesn't go away
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, const KeyType &key,
+							BPlusTreeActionType type) {
+  if (node->IsLeafPage()) {
+	auto leaf_page = static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+	int capacity = B_PLUS_TREE_LEAF_PAGE_TYPE::Capacity();
+	if (type == BPlusTreeActionType::Insert) {
+	  return leaf_page->CanInsert(key);
+	}
+	if (node->IsRootPage()) {
+	  return node->GetSize() > 1;
+	}
+	return leaf_page->GetFreeSpace() + B_PLUS_TREE_LEAF_PAGE_TYPE::MaxEntrySize() <= capacity - capacity / 2;
+  }
+  typedef BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> InternalPage;
+  auto internal_page = static_cast<InternalPage *>(node);
+  int capacity = InternalPage::Capacity();
+  if (type == BPlusTreeActionType::Insert) {
+	// the separator coming up from a split is at most that long
+	return internal_page->GetFreeSpace() >= InternalPage::MaxEntrySize();
+  }
+  if (node->IsRootPage()) {
+	return node->GetSize() > 2;
+  }
+  return internal_page->GetFreeSpace() + InternalPage::MaxEntrySize() <= capacity - capacity / 2;
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
@@ -902,5 +1277,7 @@ template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTree<GenericKey<256>, RID, GenericComparator<256>>;
 
 } // namespace cmudb 
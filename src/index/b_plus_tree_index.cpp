@@ -2,6 +2,7 @@
  * b_plus_tree_index.cpp
  */
 
+#include "common/exception.h"
 #include "index/b_plus_tree_index.h"
 
 namespace cmudb {
@@ -21,7 +22,9 @@ void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  if (!index_key.SetFromKey(key, GetKeySchema())) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "key too large for the index");
+  }
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -29,9 +32,11 @@ void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
                                        Transaction *transaction) {
-  // construct delete index key
+  // construct delete index key, one too large was never inserted
   KeyType index_key;
-  index_key.SetFromKey(key);
+  if (!index_key.SetFromKey(key, GetKeySchema())) {
+    return;
+  }
 
   container_.Remove(index_key, transaction);
 }
@@ -39,16 +44,45 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
                                    Transaction *transaction) {
-  // construct scan index key
+  // construct scan index key, one too large was never inserted
   KeyType index_key;
-  index_key.SetFromKey(key);
+  if (!index_key.SetFromKey(key, GetKeySchema())) {
+    return;
+  }
 
   container_.GetValue(index_key, result, transaction);
 }
+
+/*
+ * Build the tree bottom-up, or insert one by one if it isn't empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(std::vector<std::pair<Tuple, RID>> &entries,
+                                    Transaction *transaction) {
+  std::vector<std::pair<KeyType, ValueType>> items(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!items[i].first.SetFromKey(entries[i].first, GetKeySchema())) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "key too large for the index");
+    }
+    items[i].second = entries[i].second;
+  }
+  if (!container_.BulkLoad(items)) {
+    // inserts latch crab through the transaction's page set
+    Transaction local_transaction(0);
+    if (transaction == nullptr) {
+      transaction = &local_transaction;
+    }
+    for (auto &item : items) {
+      container_.Insert(item.first, item.second, transaction);
+    }
+  }
+}
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<GenericKey<128>, RID, GenericComparator<128>>;
+template class BPlusTreeIndex<GenericKey<256>, RID, GenericComparator<256>>;
 
 } // namespace cmudb
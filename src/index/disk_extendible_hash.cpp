@@ -0,0 +1,447 @@
+/**
+ * disk_extendible_hash.cpp
+ */
+#include <cassert>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "index/disk_extendible_hash.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+DISK_EXTENDIBLE_HASH_TYPE::DiskExtendibleHash(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t directory_page_id)
+    : index_name_(name), directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+/*
+ * Helper function to decide whether the table has any page yet
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TYPE::IsEmpty() const {
+  return directory_page_id_ == INVALID_PAGE_ID;
+}
+
+/*
+ * FNV-1a over the key bytes, then the murmur3 finalizer so that the low bits
+ * used by the directory depend on every byte
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t DISK_EXTENDIBLE_HASH_TYPE::Hash(const KeyType &key) const {
+  const unsigned char *data = reinterpret_cast<const unsigned char *>(&key);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(KeyType); i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+HashTableDirectoryPage *DISK_EXTENDIBLE_HASH_TYPE::FetchDirectoryPage() {
+  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
+  if (page == nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+HASH_TABLE_BUCKET_PAGE_TYPE *
+DISK_EXTENDIBLE_HASH_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
+  if (page == nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  return reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(page->GetData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+HASH_TABLE_BUCKET_PAGE_TYPE *
+DISK_EXTENDIBLE_HASH_TYPE::NewBucketPage(page_id_t &bucket_page_id) {
+  Page *page = buffer_pool_manager_->NewPage(bucket_page_id);
+  if (page == nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  auto bucket = reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(page->GetData());
+  bucket->Init(bucket_page_id);
+  return bucket;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * This method is used for point query
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TYPE::GetValue(const KeyType &key,
+                                         std::vector<ValueType> &result,
+                                         Transaction *transaction) {
+  table_latch_.RLock();
+  if (IsEmpty()) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  HashTableDirectoryPage *directory = FetchDirectoryPage();
+  page_id_t bucket_page_id =
+      directory->GetBucketPageId(Hash(key) & directory->GetGlobalDepthMask());
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+
+  bool found = false;
+  while (!found && bucket_page_id != INVALID_PAGE_ID) {
+    auto bucket = FetchBucketPage(bucket_page_id);
+    ValueType value;
+    if (bucket->Lookup(key, value, comparator_)) {
+      result.push_back(value);
+      found = true;
+    }
+    page_id_t next_page_id = bucket->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    bucket_page_id = next_page_id;
+  }
+  table_latch_.RUnlock();
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t DISK_EXTENDIBLE_HASH_TYPE::GetGlobalDepth() {
+  table_latch_.RLock();
+  uint32_t global_depth = 0;
+  if (!IsEmpty()) {
+    global_depth = FetchDirectoryPage()->GetGlobalDepth();
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  }
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert constant key & value pair into the table. If the bucket is full,
+ * split it (doubling the directory when the bucket is as deep as it) and try
+ * again, unless the directory page is full: then chain an overflow page
+ * @return: since only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TYPE::Insert(const KeyType &key,
+                                       const ValueType &value,
+                                       Transaction *transaction) {
+  table_latch_.WLock();
+  if (IsEmpty()) {
+    StartNewTable();
+  }
+  HashTableDirectoryPage *directory = FetchDirectoryPage();
+  uint32_t hash = Hash(key);
+  bool directory_dirty = false;
+  bool inserted = false;
+
+  while (true) {
+    uint32_t bucket_idx = hash & directory->GetGlobalDepthMask();
+    page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+
+    // reject duplicate keys, including those in overflow pages
+    bool duplicate = false;
+    page_id_t page_id = bucket_page_id;
+    while (!duplicate && page_id != INVALID_PAGE_ID) {
+      auto page = FetchBucketPage(page_id);
+      ValueType existing;
+      duplicate = page->Lookup(key, existing, comparator_);
+      page_id_t next_page_id = page->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    if (duplicate) {
+      break;
+    }
+
+    auto bucket = FetchBucketPage(bucket_page_id);
+    if (!bucket->IsFull()) {
+      bucket->Insert(key, value);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      inserted = true;
+      break;
+    }
+    uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+    if (local_depth == directory->GetGlobalDepth() && !directory->CanGrow()) {
+      InsertIntoOverflow(bucket, key, value);
+      inserted = true;
+      break;
+    }
+    if (local_depth == directory->GetGlobalDepth()) {
+      directory->IncrGlobalDepth();
+    }
+    // the records may all stay on one side, so try again after the split
+    SplitBucket(directory, bucket_idx, bucket);
+    directory_dirty = true;
+  }
+
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*
+ * Allocate the directory and its first bucket, then record the directory
+ * page id in the header page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::StartNewTable() {
+  Page *page = buffer_pool_manager_->NewPage(directory_page_id_);
+  if (page == nullptr) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  page_id_t bucket_page_id;
+  NewBucketPage(bucket_page_id);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+
+  auto directory = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  directory->Init(directory_page_id_, bucket_page_id);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  UpdateDirectoryPageId(true);
+}
+
+/*
+ * Split bucket by the next bit of the hash: records having it set move to a
+ * new bucket, and so do the directory slots having it set. Unpins bucket
+ * NOTE: the directory must already be deeper than the bucket
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::SplitBucket(
+    HashTableDirectoryPage *directory, uint32_t bucket_idx,
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket) {
+  uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+  assert(local_depth < directory->GetGlobalDepth());
+  assert(bucket->GetNextPageId() == INVALID_PAGE_ID);
+  uint32_t high_bit = 1u << local_depth;
+
+  page_id_t image_page_id;
+  auto image = NewBucketPage(image_page_id);
+  for (int i = 0; i < bucket->GetSize();) {
+    const MappingType &item = bucket->GetItem(i);
+    if (Hash(item.first) & high_bit) {
+      image->Insert(item.first, item.second);
+      bucket->RemoveAt(i);
+    } else {
+      i++;
+    }
+  }
+
+  for (uint32_t i = bucket_idx & (high_bit - 1); i < directory->Size();
+       i += high_bit) {
+    directory->SetLocalDepth(i, local_depth + 1);
+    if (i & high_bit) {
+      directory->SetBucketPageId(i, image_page_id);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(image_page_id, true);
+  buffer_pool_manager_->UnpinPage(bucket->GetPageId(), true);
+}
+
+/*
+ * Put the pair in the first page of the chain of bucket with room, appending
+ * a new overflow page if they are all full. Unpins bucket
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::InsertIntoOverflow(
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key,
+    const ValueType &value) {
+  while (bucket->IsFull()) {
+    page_id_t page_id = bucket->GetPageId();
+    page_id_t next_page_id = bucket->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      auto overflow = NewBucketPage(next_page_id);
+      bucket->SetNextPageId(next_page_id);
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      bucket = overflow;
+    } else {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      bucket = FetchBucketPage(next_page_id);
+    }
+  }
+  bucket->Insert(key, value);
+  buffer_pool_manager_->UnpinPage(bucket->GetPageId(), true);
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key. An overflow page left
+ * empty is unlinked and deleted, an emptied head bucket takes over the
+ * content of its first overflow page. A bucket left a quarter full merges with
+ * its split image, and the directory halves while every bucket is shallower than it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::Remove(const KeyType &key,
+                                       Transaction *transaction) {
+  table_latch_.WLock();
+  if (IsEmpty()) {
+    table_latch_.WUnlock();
+    return;
+  }
+  HashTableDirectoryPage *directory = FetchDirectoryPage();
+  uint32_t hash = Hash(key);
+  uint32_t bucket_idx = hash & directory->GetGlobalDepthMask();
+  page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = bucket_page_id;
+  bool removed = false;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = FetchBucketPage(page_id);
+    page_id_t next_page_id = page->GetNextPageId();
+    if (!page->Remove(key, comparator_)) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      prev_page_id = page_id;
+      page_id = next_page_id;
+      continue;
+    }
+    bool empty = page->IsEmpty();
+    if (empty && prev_page_id == INVALID_PAGE_ID &&
+        next_page_id != INVALID_PAGE_ID) {
+      // the head bucket stays in the directory, refill it from the chain
+      auto next = FetchBucketPage(next_page_id);
+      for (int i = 0; i < next->GetSize(); i++) {
+        page->Insert(next->GetItem(i).first, next->GetItem(i).second);
+      }
+      page->SetNextPageId(next->GetNextPageId());
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      buffer_pool_manager_->DeletePage(next_page_id);
+      empty = false;
+    }
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    if (empty && prev_page_id != INVALID_PAGE_ID) {
+      auto prev = FetchBucketPage(prev_page_id);
+      prev->SetNextPageId(next_page_id);
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    removed = true;
+    break;
+  }
+
+  // the chain may be gone now, check the head bucket itself
+  bool bucket_underflow = false;
+  if (removed) {
+    auto bucket = FetchBucketPage(bucket_page_id);
+    bucket_underflow = bucket->GetNextPageId() == INVALID_PAGE_ID &&
+                       bucket->GetSize() <= bucket->GetMaxSize() / 4;
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+
+  bool directory_dirty = false;
+  if (bucket_underflow) {
+    Merge(directory, hash);
+    directory_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+  table_latch_.WUnlock();
+}
+
+/*
+ * Merge the bucket covering hash with its split image while both have the
+ * same depth, no overflow pages and fit together in half a page. The records
+ * of the upper one move to the lower one, which every slot of both then
+ * points to, and the upper one is deleted
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::Merge(HashTableDirectoryPage *directory,
+                                      uint32_t hash) {
+  while (true) {
+    uint32_t bucket_idx = hash & directory->GetGlobalDepthMask();
+    uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+    if (local_depth == 0) {
+      break;
+    }
+    uint32_t image_idx = directory->GetSplitImageIndex(bucket_idx);
+    if (directory->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = directory->GetBucketPageId(image_idx);
+
+    auto bucket = FetchBucketPage(bucket_page_id);
+    auto image = FetchBucketPage(image_page_id);
+    // half a page at most, so that a single insert can't split it right back
+    if (bucket->GetNextPageId() != INVALID_PAGE_ID ||
+        image->GetNextPageId() != INVALID_PAGE_ID ||
+        bucket->GetSize() + image->GetSize() > bucket->GetMaxSize() / 2) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      buffer_pool_manager_->UnpinPage(image_page_id, false);
+      break;
+    }
+
+    // keep the lower slot's page, as if image had never been split from it
+    page_id_t keep_page_id = bucket_page_id;
+    page_id_t drop_page_id = image_page_id;
+    auto keep = bucket;
+    auto drop = image;
+    if (image_idx < bucket_idx) {
+      std::swap(keep_page_id, drop_page_id);
+      std::swap(keep, drop);
+    }
+    for (int i = 0; i < drop->GetSize(); i++) {
+      keep->Insert(drop->GetItem(i).first, drop->GetItem(i).second);
+    }
+    buffer_pool_manager_->UnpinPage(keep_page_id, true);
+    buffer_pool_manager_->UnpinPage(drop_page_id, false);
+
+    uint32_t low_bits = (1u << (local_depth - 1)) - 1;
+    for (uint32_t i = bucket_idx & low_bits; i < directory->Size();
+         i += low_bits + 1) {
+      directory->SetBucketPageId(i, keep_page_id);
+      directory->SetLocalDepth(i, local_depth - 1);
+    }
+    buffer_pool_manager_->DeletePage(drop_page_id);
+  }
+
+  while (directory->CanShrink()) {
+    directory->DecrGlobalDepth();
+  }
+}
+
+/*
+ * Update/Insert directory page id in header page(where page_id = 0, header_page
+ * is defined under include/page/header_page.h)
+ * Call this method everytime directory page id is changed.
+ * @parameter: insert_record      defualt value is false. When set to true,
+ * insert a record <index_name, directory_page_id> into header page instead of
+ * updating it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TYPE::UpdateDirectoryPageId(int insert_record) {
+  auto header_page = reinterpret_cast<HeaderPage *>(
+      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+
+  if (insert_record)
+    // create a new record<index_name + directory_page_id> in header_page
+    header_page->InsertRecord(index_name_, directory_page_id_);
+  else
+    // update directory_page_id in header_page
+    header_page->UpdateRecord(index_name_, directory_page_id_);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+template class DiskExtendibleHash<GenericKey<4>, RID, GenericComparator<4>>;
+template class DiskExtendibleHash<GenericKey<8>, RID, GenericComparator<8>>;
+template class DiskExtendibleHash<GenericKey<16>, RID, GenericComparator<16>>;
+template class DiskExtendibleHash<GenericKey<32>, RID, GenericComparator<32>>;
+template class DiskExtendibleHash<GenericKey<64>, RID, GenericComparator<64>>;
+template class DiskExtendibleHash<GenericKey<128>, RID, GenericComparator<128>>;
+template class DiskExtendibleHash<GenericKey<256>, RID, GenericComparator<256>>;
+
+} // namespace cmudb
@@ -1,6 +1,7 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
 
 #include "index/index_iterator.h"
@@ -13,7 +14,10 @@ namespace cmudb {
    */
   INDEX_TEMPLATE_ARGUMENTS
   INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE* leaf_page, BufferPoolManager *buffer_pool_manager, int index)
-    :current_page_(leaf_page), buffer_pool_manager_(buffer_pool_manager), current_index_in_page_(index), max_size_in_current_page_(leaf_page->GetSize()) {}
+    :current_page_(leaf_page), buffer_pool_manager_(buffer_pool_manager), current_index_in_page_(index), max_size_in_current_page_(leaf_page->GetSize()),
+     read_ahead_window_(1), read_ahead_hits_(0) {
+    SetMaxReadAhead(INDEX_READ_AHEAD_PAGES);
+  }
 
   INDEX_TEMPLATE_ARGUMENTS
   INDEXITERATOR_TYPE::~IndexIterator() {
@@ -28,7 +32,8 @@ namespace cmudb {
   
   INDEX_TEMPLATE_ARGUMENTS
   const MappingType &INDEXITERATOR_TYPE::operator*() {
-    return current_page_->GetItem(current_index_in_page_);
+    item_ = current_page_->GetItem(current_index_in_page_);
+    return item_;
   }
 
   INDEX_TEMPLATE_ARGUMENTS
@@ -40,15 +45,74 @@ namespace cmudb {
 	return *this;
       }
       buffer_pool_manager_->UnpinPage(current_page_->GetPageId(), false);
-      
-      current_page_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(buffer_pool_manager_->FetchPage(next_page_id)->GetData());
+
+      bool prefetched = !read_ahead_.empty() && read_ahead_.front() == next_page_id;
+      if (prefetched) {
+	read_ahead_.pop_front();
+      } else {
+	// the leaf chain changed under the scan
+	read_ahead_.clear();
+      }
+      Page *page = buffer_pool_manager_->TryFetchPage(next_page_id);
+      if (page != nullptr) {
+	if (prefetched && ++read_ahead_hits_ >= read_ahead_window_) {
+	  // consumption is slower than I/O, hold fewer leaves
+	  read_ahead_window_ = std::max<size_t>(read_ahead_window_ - 1, 1);
+	  read_ahead_hits_ = 0;
+	}
+      } else {
+	if (prefetched) {
+	  // the scan caught up with I/O, overlap more of it
+	  read_ahead_window_ = std::min(read_ahead_window_ * 2, max_read_ahead_);
+	  read_ahead_hits_ = 0;
+	}
+	page = buffer_pool_manager_->FetchPage(next_page_id);
+      }
+      current_page_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(page->GetData());
       current_index_in_page_ = 0;
       max_size_in_current_page_ = current_page_->GetSize();
-    } 
+    }
+    ReadAhead();
 
     return *this;
   }
 
+  INDEX_TEMPLATE_ARGUMENTS
+  void INDEXITERATOR_TYPE::SetMaxReadAhead(size_t max_read_ahead) {
+    // prefetched leaves are unpinned, don't let them evict each other
+    max_read_ahead_ = std::min(max_read_ahead, buffer_pool_manager_->GetPoolSize() / 4);
+    read_ahead_window_ = std::max<size_t>(std::min(read_ahead_window_, max_read_ahead_), 1);
+  }
+
+  /*
+   * Keep the window of leaves after the current one being prefetched.
+   * Extending it needs the next page id of its last leaf, so it stops at a
+   * leaf not loaded yet
+   */
+  INDEX_TEMPLATE_ARGUMENTS
+  void INDEXITERATOR_TYPE::ReadAhead() {
+    while (read_ahead_.size() < read_ahead_window_ && max_read_ahead_ > 0) {
+      page_id_t next_page_id;
+      if (read_ahead_.empty()) {
+	next_page_id = current_page_->GetNextPageId();
+      } else {
+	Page *page = buffer_pool_manager_->TryFetchPage(read_ahead_.back());
+	if (page == nullptr) {
+	  break;
+	}
+	page->RLatch();
+	next_page_id = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE*>(page->GetData())->GetNextPageId();
+	page->RUnlatch();
+	buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      }
+      if (next_page_id == INVALID_PAGE_ID) {
+	break;
+      }
+      buffer_pool_manager_->Prefetch(next_page_id);
+      read_ahead_.push_back(next_page_id);
+    }
+  }
+
   
 
   template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
@@ -56,4 +120,6 @@ namespace cmudb {
   template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
   template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
   template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+  template class IndexIterator<GenericKey<128>, RID, GenericComparator<128>>;
+  template class IndexIterator<GenericKey<256>, RID, GenericComparator<256>>;
 } // namespace cmudb
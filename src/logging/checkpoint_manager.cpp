@@ -0,0 +1,48 @@
+/**
+ * checkpoint_manager.cpp
+ */
+
+#include "logging/checkpoint_manager.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+/*
+ * Take a fuzzy checkpoint, nothing is stopped:
+ * 1. append BEGIN_CHECKPOINT
+ * 2. append END_CHECKPOINT with the dirty page table and the active
+ *    transaction table, taken after the begin record, and force the log
+ * 3. write back every page that may differ from disk, one buffer pool
+ *    instance at a time, so any change logged before BEGIN_CHECKPOINT is on
+ *    disk afterwards
+ * 4. record BEGIN_CHECKPOINT in the header page, redo starts from there
+ * A crash before step 4 leaves the previous checkpoint in effect.
+ * NOTE: the caller must not hold any page latch
+ */
+void CheckpointManager::Checkpoint() {
+  LogRecord begin_record(INVALID_TXN_ID, INVALID_LSN,
+                         LogRecordType::BEGIN_CHECKPOINT);
+  int begin_offset;
+  lsn_t begin_lsn = log_manager_->AppendLogRecord(begin_record, &begin_offset);
+
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  std::unordered_map<txn_id_t, lsn_t> active_txns;
+  buffer_pool_manager_->GetDirtyPages(dirty_pages);
+  transaction_manager_->GetActiveTxns(active_txns);
+  LogRecord end_record(LogRecordType::END_CHECKPOINT, dirty_pages,
+                       active_txns);
+  log_manager_->AppendLogRecord(end_record);
+  log_manager_->Flush();
+
+  buffer_pool_manager_->FlushAllPages();
+
+  HeaderPage *header_page = static_cast<HeaderPage *>(
+      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  assert(header_page != nullptr);
+  header_page->WLatch();
+  header_page->SetCheckpoint(begin_lsn, begin_offset);
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  buffer_pool_manager_->FlushPage(HEADER_PAGE_ID);
+}
+
+} // namespace cmudb
@@ -13,17 +13,26 @@ namespace cmudb {
  * larger LSN than persistent LSN)
  */
 void LogManager::RunFlushThread() {
+  // appenders look at flush_thread_ under the latch
+  std::lock_guard<std::mutex> guard(latch_);
   ENABLE_LOGGING = true;
   flush_thread_ = new std::thread([&]() {
 	std::unique_lock<std::mutex> latch(latch_);
 
 	for (;;) {
-	  cv_.wait_for(latch, LOG_TIMEOUT);
+	  cv_.wait_for(latch, LOG_TIMEOUT,
+				   [&]() { return flush_requested_ || !ENABLE_LOGGING; });
+	  if (flush_requested_) {
+		// an appender filled the log buffer and swapped it
+		flush_requested_ = false;
+		WriteFlushBuffer(latch);
+		continue;
+	  }
 	  if (ENABLE_LOGGING == false) {
 		return;
 	  }
 
-	  disk_manager_->WriteLog(flush_buffer_, flush_offset_);
+	  FlushLogBuffer(latch);
 	}
   });
 }
@@ -39,7 +48,13 @@ void LogManager::StopFlushThread() {
   }
 
   flush_thread_->join();
-  delete flush_thread_;
+  {
+	std::unique_lock<std::mutex> latch(latch_);
+	delete flush_thread_;
+	flush_thread_ = nullptr;
+  }
+  // what was appended last still reaches the disk
+  Flush();
 }
 
 /*
@@ -62,47 +77,159 @@ void LogManager::StopFlushThread() {
  *  }
  *
  */
-lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
-
+lsn_t LogManager::AppendLogRecord(LogRecord &log_record, int *log_offset) {
+  std::unique_lock<std::mutex> latch(latch_);
+
+  while (log_record.GetSize() > log_buffer_size_) {
+	// only the checkpoint of a large buffer pool gets there, the buffers grow
+	// to fit it once both are empty
+	if (flushing_ || log_offset_ > 0) {
+	  FlushLogBuffer(latch);
+	  continue;
+	}
+	delete[] log_buffer_;
+	delete[] flush_buffer_;
+	log_buffer_size_ = log_record.GetSize();
+	log_buffer_ = new char[log_buffer_size_];
+	flush_buffer_ = new char[log_buffer_size_];
+  }
+  while (!SafetyForAppend(log_record)) {
+	if (flushing_) {
+	  // the flush buffer is still being written, nowhere to swap to
+	  flushed_cv_.wait(latch);
+	  continue;
+	}
+	SwapLogBuffer();
+	if (ENABLE_LOGGING && flush_thread_ != nullptr) {
+	  flush_requested_ = true;
+	  cv_.notify_one();
+	} else {
+	  WriteFlushBuffer(latch);
+	}
+  }
   log_record.lsn_ = next_lsn_++;
-
-  if (!SafetyForAppend(log_record)) {
-	std::unique_lock<std::mutex> latch(latch_);
-
-	std::swap(log_buffer_, flush_buffer_);
-	flush_offset_ = log_offset_;
-	log_offset_ = 0;
-	cv_.notify_one();
+  if (log_offset != nullptr) {
+	*log_offset = log_file_offset_ + log_offset_;
   }
 
+  // First, serialize the must have fields(20 bytes in total)
   memcpy(log_buffer_ + log_offset_, &log_record, 20);
-  // int pos = log_offset_ + 20;
-
-
-  return INVALID_LSN;
-}
-
-bool LogManager::SafetyForAppend(LogRecord &log_record) {
-  int left_size = LOG_BUFFER_SIZE - log_offset_;
-  int need_size = 0;
+  int pos = log_offset_ + 20;
 
-  assert(log_record.GetLogRecordType() != LogRecordType::INVALID);
   switch (log_record.GetLogRecordType()) {
 	case LogRecordType::INSERT:
+	  memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
+	  pos += sizeof(RID);
+	  log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
+	  break;
 	case LogRecordType::MARKDELETE:
 	case LogRecordType::APPLYDELETE:
-	case LogRecordType::ROLLBACKDELETE: need_size = 24 + sizeof(RID) + log_record.GetSize();
+	case LogRecordType::ROLLBACKDELETE:
+	  memcpy(log_buffer_ + pos, &log_record.delete_rid_, sizeof(RID));
+	  pos += sizeof(RID);
+	  log_record.delete_tuple_.SerializeTo(log_buffer_ + pos);
 	  break;
 	case LogRecordType::UPDATE:
-	  need_size = 28 + sizeof(RID) + log_record.old_tuple_.GetLength()
-		  + log_record.new_tuple_.GetLength();
+	  memcpy(log_buffer_ + pos, &log_record.update_rid_, sizeof(RID));
+	  pos += sizeof(RID);
+	  log_record.old_tuple_.SerializeTo(log_buffer_ + pos);
+	  pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+	  log_record.new_tuple_.SerializeTo(log_buffer_ + pos);
+	  break;
+	case LogRecordType::NEWPAGE:
+	  memcpy(log_buffer_ + pos, &log_record.prev_page_id_, sizeof(page_id_t));
 	  break;
-	case LogRecordType::NEWPAGE: need_size = 24;
+	case LogRecordType::END_CHECKPOINT: {
+	  int32_t count = log_record.dirty_pages_.size();
+	  memcpy(log_buffer_ + pos, &count, sizeof(int32_t));
+	  pos += sizeof(int32_t);
+	  for (auto &entry : log_record.dirty_pages_) {
+		memcpy(log_buffer_ + pos, &entry.first, sizeof(page_id_t));
+		memcpy(log_buffer_ + pos + sizeof(page_id_t), &entry.second,
+			   sizeof(lsn_t));
+		pos += sizeof(page_id_t) + sizeof(lsn_t);
+	  }
+	  count = log_record.active_txns_.size();
+	  memcpy(log_buffer_ + pos, &count, sizeof(int32_t));
+	  pos += sizeof(int32_t);
+	  for (auto &entry : log_record.active_txns_) {
+		memcpy(log_buffer_ + pos, &entry.first, sizeof(txn_id_t));
+		memcpy(log_buffer_ + pos + sizeof(txn_id_t), &entry.second,
+			   sizeof(lsn_t));
+		pos += sizeof(txn_id_t) + sizeof(lsn_t);
+	  }
 	  break;
-	default:need_size = 20;
+	}
+	default:
+	  break;
+  }
+
+  log_offset_ += log_record.GetSize();
+  last_lsn_ = log_record.lsn_;
+  return log_record.lsn_;
+}
+
+/*
+ * Write every record appended so far to the log file, returns once they are
+ * on disk
+ */
+void LogManager::Flush() {
+  std::unique_lock<std::mutex> latch(latch_);
+  FlushLogBuffer(latch);
+}
+
+/*
+ * Wait for the write of the flush buffer in progress if any, then swap the
+ * log buffer with it and write it out
+ * NOTE: caller must hold latch_ through "latch"
+ */
+void LogManager::FlushLogBuffer(std::unique_lock<std::mutex> &latch) {
+  while (flushing_) {
+	flushed_cv_.wait(latch);
+  }
+  if (log_offset_ == 0) {
+	return;
   }
+  SwapLogBuffer();
+  WriteFlushBuffer(latch);
+}
+
+/*
+ * Hand the records of the log buffer over to the flush buffer, appending
+ * goes on in the other one
+ * NOTE: caller must hold latch_, and the flush buffer must be free
+ */
+void LogManager::SwapLogBuffer() {
+  assert(!flushing_);
+  std::swap(log_buffer_, flush_buffer_);
+  flush_offset_ = log_offset_;
+  log_offset_ = 0;
+  log_file_offset_ += flush_offset_;
+  flush_lsn_ = last_lsn_;
+  flushing_ = true;
+}
+
+/*
+ * Write the flush buffer out with latch_ released, so that appending goes on
+ * meanwhile, then advance persistent_lsn_ past its records
+ * NOTE: caller must hold latch_ through "latch"
+ */
+void LogManager::WriteFlushBuffer(std::unique_lock<std::mutex> &latch) {
+  assert(flushing_);
+  latch.unlock();
+  disk_manager_->WriteLog(flush_buffer_, flush_offset_);
+  latch.lock();
+  persistent_lsn_ = flush_lsn_;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
 
-  return need_size <= left_size;
+bool LogManager::SafetyForAppend(LogRecord &log_record) {
+  int left_size = log_buffer_size_ - log_offset_;
+
+  assert(log_record.GetLogRecordType() != LogRecordType::INVALID);
+  // the size of every record covers its whole serialized form
+  return log_record.GetSize() <= left_size;
 }
 
 } // namespace cmudb
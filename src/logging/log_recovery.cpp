@@ -2,7 +2,10 @@
  * log_recovey.cpp
  */
 
+#include <unordered_set>
+
 #include "logging/log_recovery.h"
+#include "page/header_page.h"
 #include "page/table_page.h"
 
 namespace cmudb {
@@ -13,17 +16,194 @@ namespace cmudb {
  */
 bool LogRecovery::DeserializeLogRecord(const char *data,
                                              LogRecord &log_record) {
-  return false;
+  // the record must lie within the log buffer
+  int left_size = log_buffer_size_ - static_cast<int>(data - log_buffer_);
+  if (left_size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int32_t size = *reinterpret_cast<const int32_t *>(data);
+  LogRecordType type = *reinterpret_cast<const LogRecordType *>(data + 16);
+  if (size < LogRecord::HEADER_SIZE || size > left_size ||
+      type <= LogRecordType::INVALID || type > LogRecordType::END_CHECKPOINT) {
+    // either cut by the end of the buffer, or past the end of the log
+    return false;
+  }
+
+  log_record.size_ = size;
+  log_record.lsn_ = *reinterpret_cast<const lsn_t *>(data + 4);
+  log_record.txn_id_ = *reinterpret_cast<const txn_id_t *>(data + 8);
+  log_record.prev_lsn_ = *reinterpret_cast<const lsn_t *>(data + 12);
+  log_record.log_record_type_ = type;
+  const char *pos = data + LogRecord::HEADER_SIZE;
+
+  switch (type) {
+  case LogRecordType::INSERT:
+    log_record.insert_rid_ = *reinterpret_cast<const RID *>(pos);
+    log_record.insert_tuple_.DeserializeFrom(pos + sizeof(RID));
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    log_record.delete_rid_ = *reinterpret_cast<const RID *>(pos);
+    log_record.delete_tuple_.DeserializeFrom(pos + sizeof(RID));
+    break;
+  case LogRecordType::UPDATE:
+    log_record.update_rid_ = *reinterpret_cast<const RID *>(pos);
+    pos += sizeof(RID);
+    log_record.old_tuple_.DeserializeFrom(pos);
+    pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+    log_record.new_tuple_.DeserializeFrom(pos);
+    break;
+  case LogRecordType::NEWPAGE:
+    log_record.prev_page_id_ = *reinterpret_cast<const page_id_t *>(pos);
+    break;
+  case LogRecordType::END_CHECKPOINT: {
+    int32_t count = *reinterpret_cast<const int32_t *>(pos);
+    pos += sizeof(int32_t);
+    for (int32_t i = 0; i < count; i++) {
+      log_record.dirty_pages_[*reinterpret_cast<const page_id_t *>(pos)] =
+          *reinterpret_cast<const lsn_t *>(pos + sizeof(page_id_t));
+      pos += sizeof(page_id_t) + sizeof(lsn_t);
+    }
+    count = *reinterpret_cast<const int32_t *>(pos);
+    pos += sizeof(int32_t);
+    for (int32_t i = 0; i < count; i++) {
+      log_record.active_txns_[*reinterpret_cast<const txn_id_t *>(pos)] =
+          *reinterpret_cast<const lsn_t *>(pos + sizeof(txn_id_t));
+      pos += sizeof(txn_id_t) + sizeof(lsn_t);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return true;
 }
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
- *read log file from the beginning to end (you must prefetch log records into
- *log buffer to reduce unnecessary I/O operations), remember to compare page's
- *LSN with log_record's sequence number, and also build active_txn_ table &
- *lsn_mapping_ table
+ *read log file from the last complete checkpoint recorded in the header page
+ *(or from the beginning if there is none) to end, prefetching log records
+ *into log buffer to reduce unnecessary I/O operations. Every change logged
+ *before that checkpoint is already on disk. Compare page's LSN with
+ *log_record's sequence number, and also build active_txn_ table (seeded by
+ *the checkpoint's active transactions) & lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  offset_ = 0;
+  HeaderPage *header_page = static_cast<HeaderPage *>(
+      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  if (header_page != nullptr) {
+    if (header_page->GetCheckpointLSN() != INVALID_LSN) {
+      offset_ = header_page->GetCheckpointOffset();
+    }
+    buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+  }
+
+  // transactions that ended after the checkpoint began
+  std::unordered_set<txn_id_t> ended_txn;
+  while (disk_manager_->ReadLog(log_buffer_, log_buffer_size_, offset_)) {
+    int pos = 0;
+    for (;;) {
+      LogRecord log_record;
+      if (!DeserializeLogRecord(log_buffer_ + pos, log_record)) {
+        break;
+      }
+      lsn_mapping_[log_record.lsn_] = offset_ + pos;
+      pos += log_record.size_;
+
+      if (log_record.log_record_type_ == LogRecordType::END_CHECKPOINT) {
+        for (auto &entry : log_record.active_txns_) {
+          if (ended_txn.count(entry.first) == 0) {
+            // keeps a later lsn already met after the begin record
+            active_txn_.emplace(entry.first, entry.second);
+          }
+        }
+        continue;
+      }
+      if (log_record.txn_id_ != INVALID_TXN_ID) {
+        if (log_record.log_record_type_ == LogRecordType::COMMIT ||
+            log_record.log_record_type_ == LogRecordType::ABORT) {
+          active_txn_.erase(log_record.txn_id_);
+          ended_txn.insert(log_record.txn_id_);
+        } else {
+          active_txn_[log_record.txn_id_] = log_record.lsn_;
+        }
+      }
+      RedoLogRecord(log_record);
+    }
+    if (pos == 0) {
+      int32_t size = *reinterpret_cast<const int32_t *>(log_buffer_);
+      if (size > log_buffer_size_ &&
+          offset_ + size <= disk_manager_->GetLogSize()) {
+        // a record larger than the buffer, like the log manager's grows
+        delete[] log_buffer_;
+        log_buffer_size_ = size;
+        log_buffer_ = new char[log_buffer_size_];
+        continue;
+      }
+      // nothing complete left in the log
+      break;
+    }
+    offset_ += pos;
+  }
+}
+
+/*
+ * Apply a tuple level log record to its table page unless the page already
+ * holds it. NEWPAGE records carry no page id of their own and are skipped
+ */
+void LogRecovery::RedoLogRecord(LogRecord &log_record) {
+  RID rid;
+  switch (log_record.log_record_type_) {
+  case LogRecordType::INSERT:
+    rid = log_record.insert_rid_;
+    break;
+  case LogRecordType::MARKDELETE:
+  case LogRecordType::APPLYDELETE:
+  case LogRecordType::ROLLBACKDELETE:
+    rid = log_record.delete_rid_;
+    break;
+  case LogRecordType::UPDATE:
+    rid = log_record.update_rid_;
+    break;
+  default:
+    return;
+  }
+
+  TablePage *page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  assert(page != nullptr);
+  if (page->GetLSN() >= log_record.lsn_) {
+    buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    return;
+  }
+  switch (log_record.log_record_type_) {
+  case LogRecordType::INSERT:
+    page->InsertTuple(log_record.insert_tuple_, rid, nullptr, nullptr,
+                      nullptr);
+    break;
+  case LogRecordType::MARKDELETE:
+    page->MarkDelete(rid, nullptr, nullptr, nullptr);
+    break;
+  case LogRecordType::APPLYDELETE:
+    page->ApplyDelete(rid, nullptr, nullptr);
+    break;
+  case LogRecordType::ROLLBACKDELETE:
+    page->RollbackDelete(rid, nullptr, nullptr);
+    break;
+  case LogRecordType::UPDATE: {
+    Tuple old_tuple;
+    page->UpdateTuple(log_record.new_tuple_, old_tuple, rid, nullptr, nullptr,
+                      nullptr);
+    break;
+  }
+  default:
+    break;
+  }
+  page->SetLSN(log_record.lsn_);
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
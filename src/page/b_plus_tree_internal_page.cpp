@@ -1,6 +1,7 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -15,7 +16,7 @@ namespace cmudb {
 /*
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * max page size (the pairs with full-width keys that fit)
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
@@ -25,28 +26,77 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
 
-  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeInternalPage)) / (sizeof(KeyType)+sizeof(ValueType)));
+  SetMaxSize(Capacity() / MaxEntrySize());
 }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::Capacity() {
+  return PAGE_SIZE - sizeof(BPlusTreeInternalPage);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::MaxEntrySize() {
+  return sizeof(uint16_t) + sizeof(ValueType) + sizeof(KeyType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::PairEnd(int index) const {
+  return index == 0 ? PAGE_SIZE : offsets_[index - 1];
+}
+
+/*
+ * Bytes between the offsets and the pairs
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetFreeSpace() const {
+  return PairEnd(GetSize()) - static_cast<int>(sizeof(BPlusTreeInternalPage)) -
+         GetSize() * static_cast<int>(sizeof(uint16_t));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderfull() const {
+  return GetFreeSpace() > Capacity() - Capacity() / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanInsert(const KeyType &key) const {
+  return GetFreeSpace() >= static_cast<int>(sizeof(uint16_t) + sizeof(ValueType)) +
+                           KeyLength(key);
+}
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // because the key array in the internalnode is not full
-  // but we can use it for other purpose
-  assert(index >= 0 && index < GetMaxSize());
-
-  KeyType key = array[index].first;
+  assert(index >= 0 && index < GetSize());
+
+  KeyType key;
+  char *key_data = reinterpret_cast<char *>(&key);
+  memset(key_data, 0, sizeof(KeyType));
+  int key_begin = offsets_[index] + sizeof(ValueType);
+  memcpy(key_data, reinterpret_cast<const char *>(this) + key_begin,
+         PairEnd(index) - key_begin);
   return key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index,
+                                                 const KeyType &key) const {
+  int key_size = PairEnd(index) - offsets_[index] - sizeof(ValueType);
+  return GetFreeSpace() + key_size >= KeyLength(key);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
-  // because the key array in the internalnode is not full
-  assert(index > 0 && index < GetMaxSize());
+  // the first key is never stored
+  assert(index > 0 && index < GetSize());
+  assert(CanSetKeyAt(index, key));
 
-  array[index].first = key;
+  ValueType value = ValueAt(index);
+  RemoveAt(index);
+  InsertAt(index, key, value);
 }
 
 /*
@@ -56,7 +106,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
   for (int i = 0; i < GetSize(); ++i) {
-    if (array[i].second == value)
+    if (ValueAt(i) == value)
       return i;
   }
 
@@ -70,8 +120,106 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
   // value index can start with 0
-  assert(index >= 0 && index < GetMaxSize());
-  return array[index].second;
+  assert(index >= 0 && index < GetSize());
+  ValueType value;
+  memcpy(&value, reinterpret_cast<const char *>(this) + offsets_[index],
+         sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItems(
+    std::vector<MappingType> &items) const {
+  items.clear();
+  items.reserve(GetSize() + 1);
+  for (int i = 0; i < GetSize(); i++) {
+    items.emplace_back(KeyAt(i), ValueAt(i));
+  }
+}
+
+/*
+ * Put key & value pair at index, moving the following pairs down. It must fit
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, const KeyType &key,
+                                              const ValueType &value) {
+  char *data = reinterpret_cast<char *>(this);
+  int key_size = index == 0 ? 0 : KeyLength(key);
+  int entry_size = sizeof(ValueType) + key_size;
+  assert(GetFreeSpace() >= entry_size + static_cast<int>(sizeof(uint16_t)));
+
+  int pairs_begin = PairEnd(GetSize());
+  int end = PairEnd(index);
+  memmove(data + pairs_begin - entry_size, data + pairs_begin, end - pairs_begin);
+  for (int i = GetSize(); i > index; i--) {
+    offsets_[i] = offsets_[i - 1] - entry_size;
+  }
+  offsets_[index] = end - entry_size;
+  memcpy(data + offsets_[index], &value, sizeof(ValueType));
+  memcpy(data + offsets_[index] + sizeof(ValueType), &key, key_size);
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAt(int index) {
+  char *data = reinterpret_cast<char *>(this);
+  int begin = offsets_[index];
+  int entry_size = PairEnd(index) - begin;
+  int pairs_begin = PairEnd(GetSize());
+  memmove(data + pairs_begin + entry_size, data + pairs_begin, begin - pairs_begin);
+  for (int i = index; i < GetSize() - 1; i++) {
+    offsets_[i] = offsets_[i + 1] + entry_size;
+  }
+  IncreaseSize(-1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFrom(const MappingType *items,
+                                              int size) {
+  SetSize(0);
+  for (int i = 0; i < size; i++) {
+    InsertAt(i, items[i].first, items[i].second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Adopt(
+    int begin, int end, BufferPoolManager *buffer_pool_manager) {
+  for (int i = begin; i < end; i++) {
+    auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(ValueAt(i))->GetData());
+    child_page->SetParentPageId(GetPageId());
+    buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  }
+}
+
+/*
+ * Index of the pair that goes up to the parent when cutting the "size" pairs
+ * at items in two pages, so that the fuller page takes as few bytes as
+ * possible. It becomes the first pair of the second page, without its key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::SplitIndex(const MappingType *items,
+                                               int size) {
+  assert(size >= 2);
+  const int pair_size = sizeof(uint16_t) + sizeof(ValueType);
+  int total = 0;
+  for (int i = 1; i < size; i++) {
+    total += pair_size + KeyLength(items[i].first);
+  }
+  // first = bytes of pairs [0, i), last = bytes of pairs (i, size)
+  int first = pair_size;
+  int last = total - pair_size - KeyLength(items[1].first);
+  int middle = 1;
+  int space = std::max(first, pair_size + last);
+  for (int i = 2; i < size; i++) {
+    first += pair_size + KeyLength(items[i - 1].first);
+    last -= pair_size + KeyLength(items[i].first);
+    if (std::max(first, pair_size + last) < space) {
+      space = std::max(first, pair_size + last);
+      middle = i;
+    }
+  }
+  return middle;
 }
 
 /*****************************************************************************
@@ -86,19 +234,84 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
+  // the first key larger than "key" (binary search), the key of the first
+  // child is not one
+  int index = 1 + PartitionPoint(offsets_ + 1, GetSize() - 1,
+                                 [&](const uint16_t &offset) {
+                                   int i = static_cast<int>(&offset - offsets_);
+                                   return comparator(KeyAt(i), key) <= 0;
+                                 });
+  return ValueAt(index - 1);
+}
 
-  for (int i = 1; i < GetSize(); ++i) {
-    if (comparator(key, array[i].first) < 0) {
-      return array[i-1].second;
+/*
+ * Lookup for a reader that doesn't latch the page (see
+ * BPlusTree::GetValueOptimistic), while a writer may be changing it. The size
+ * and every offset are checked before they are used, so a page caught half
+ * written is still read within its bounds.
+ * @return: false if the page is not consistent; otherwise value is the child
+ * to go to, not to be trusted before the version of the page is validated
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupOptimistic(
+    const KeyType &key, ValueType &value,
+    const KeyComparator &comparator) const {
+  const int key_size = static_cast<int>(sizeof(KeyType));
+  const int value_size = static_cast<int>(sizeof(ValueType));
+  int size = GetSize();
+  if (size < 1 ||
+      size > (PAGE_SIZE - static_cast<int>(sizeof(BPlusTreeInternalPage))) /
+                 static_cast<int>(sizeof(uint16_t))) {
+    return false;
+  }
+  int offsets_end = sizeof(BPlusTreeInternalPage) + size * sizeof(uint16_t);
+  const char *data = reinterpret_cast<const char *>(this);
+
+  // the key of pair index into other and where the pair begins, unless the
+  // pair is out of bounds
+  bool consistent = true;
+  KeyType other;
+  int pair_begin = 0;
+  auto key_at = [&](int index) {
+    pair_begin = offsets_[index];
+    int pair_end = index == 0 ? PAGE_SIZE : offsets_[index - 1];
+    int stored_size = pair_end - pair_begin - value_size;
+    if (pair_begin < offsets_end || pair_end > PAGE_SIZE || stored_size < 0 ||
+        stored_size > key_size) {
+      consistent = false;
+      return false;
     }
+    char *key_data = reinterpret_cast<char *>(&other);
+    memcpy(key_data, data + pair_begin + value_size, stored_size);
+    memset(key_data + stored_size, 0, key_size - stored_size);
+    return true;
+  };
+  int index = 1 + PartitionPoint(offsets_ + 1, size - 1,
+                                 [&](const uint16_t &offset) {
+                                   return key_at(static_cast<int>(
+                                              &offset - offsets_)) &&
+                                          comparator(other, key) <= 0;
+                                 });
+  if (!consistent || !key_at(index - 1)) {
+    return false;
   }
-
-  return array[GetSize()-1].second;
+  memcpy(&value, data + pair_begin, value_size);
+  return true;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * Append new_key & new_value as the last child, the key of the first child is
+ * unused as usual
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key,
+                                            const ValueType &value) {
+  InsertAt(GetSize(), key, value);
+}
+
 /*
  * Populate new root page with old_value + new_key & new_value
  * When the insertion cause overflow from leaf page all the way upto the root
@@ -109,28 +322,22 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  SetSize(2);
-  array[0] = std::make_pair(new_key, old_value);
-  array[1] = std::make_pair(new_key, new_value);
+  SetSize(0);
+  InsertAt(0, new_key, old_value);
+  InsertAt(1, new_key, new_value);
 }
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
- * old_value
+ * old_value, the caller makes sure it fits (CanInsert)
  * @return:  new size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  assert(GetSize() < GetMaxSize());
-
   int old_index = ValueIndex(old_value);
   assert(old_index != -1);
-  // use memmove for overlapping area
-  memmove(array + old_index + 2, array + old_index + 1, (GetSize() - old_index - 1) * (sizeof(MappingType)));
-  array[old_index + 1].first = new_key;
-  array[old_index + 1].second = new_value;
-  IncreaseSize(1);
+  InsertAt(old_index + 1, new_key, new_value);
   return GetSize();
 }
 
@@ -138,29 +345,27 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Insert new_key & new_value after old_value, then move the pairs after the
+ * split point to the brand-new "recipient" page, which adopts their children
+ * @return: the key that separates the two pages, for their parent
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
-    BPlusTreeInternalPage *recipient,
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAndMoveHalfTo(
+    const ValueType &old_value, const KeyType &new_key,
+    const ValueType &new_value, BPlusTreeInternalPage *recipient,
     BufferPoolManager *buffer_pool_manager) {
-  int origin_size = GetSize();
-  SetSize(GetSize() / 2);
-  recipient->CopyHalfFrom(array + GetSize(), origin_size - GetSize(), buffer_pool_manager);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  for (int i = 0; i < size; ++i) {
-    // the recipient is a brand new page
-    auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(items[i].second)->GetData());
-    child_page->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
-  }
-
-  memmove(array, items, size * sizeof(MappingType));
-  IncreaseSize(size);
+  std::vector<MappingType> items;
+  GetItems(items);
+  int old_index = ValueIndex(old_value);
+  assert(old_index != -1);
+  items.insert(items.begin() + old_index + 1, std::make_pair(new_key, new_value));
+
+  int size = static_cast<int>(items.size());
+  int middle = SplitIndex(items.data(), size);
+  CopyFrom(items.data(), middle);
+  recipient->CopyFrom(items.data() + middle, size - middle);
+  recipient->Adopt(0, recipient->GetSize(), buffer_pool_manager);
+  return items[middle].first;
 }
 
 /*****************************************************************************
@@ -173,8 +378,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
-  memmove(array + index, array + index + 1, (GetSize() - index - 1) * (sizeof(MappingType)));
-  IncreaseSize(-1);
+  RemoveAt(index);
 }
 
 /*
@@ -184,18 +388,29 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
   assert(GetSize() == 1);
+  ValueType value = ValueAt(0);
   IncreaseSize(-1);
-  return array[0].second;
+  return value;
 }
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Whether the pairs of "sibling", the next page, fit here as well, the key
+ * separating them in the parent (middle_key) becoming the key of its first
+ * child
  */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanAbsorb(
+    const BPlusTreeInternalPage *sibling, const KeyType &middle_key) const {
+  int used = 2 * Capacity() - GetFreeSpace() - sibling->GetFreeSpace();
+  return used + KeyLength(middle_key) <= Capacity();
+}
 
-// TODO(Handora): what does index_in_parent do?
+/*
+ * Remove all of key & value pairs from this page to "recipient" page, the
+ * previous one, then update relavent key & value pair in its parent page.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     BPlusTreeInternalPage *recipient, int,
@@ -213,118 +428,61 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
   // set a restriction that this_index is always bigger than recipient_index for simplicity
   assert(this_index != -1 && recipient_index != -1 && this_index == recipient_index + 1);
 
-  array[0].first = parent_page->KeyAt(this_index);
-  recipient->CopyAllFrom(array, GetSize(), buffer_pool_manager);
+  // the key in the parent separates the first child from the recipient's
+  int begin = recipient->GetSize();
+  recipient->InsertAt(begin, parent_page->KeyAt(this_index), ValueAt(0));
+  for (int i = 1; i < GetSize(); i++) {
+    recipient->InsertAt(recipient->GetSize(), KeyAt(i), ValueAt(i));
+  }
+  recipient->Adopt(begin, recipient->GetSize(), buffer_pool_manager);
   SetSize(0);
 
-  // just for removing the warnings
-  if (this_index > recipient_index)
-    parent_page->Remove(this_index);
-
+  parent_page->Remove(this_index);
   buffer_pool_manager->UnpinPage(parent_id, true);
 }
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-  for (int i = 0; i < size; i++) {
-    auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(items[i].second)->GetData());
-    child_page->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
-  }
-
-  memmove(array + GetSize(), items, size * sizeof(MappingType));
-  IncreaseSize(size);
-}
-
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to tail of "recipient"
- * page, then update relavent key & value pair in its parent page.
+ * Move pairs between this page and "sibling", the next one, through their
+ * parent page, so that both take about as many bytes.
+ * @return: false if nothing moved, the pages being as balanced as they get
+ * or the new key not fitting in the parent
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Redistribute(
+    BPlusTreeInternalPage *sibling, BufferPoolManager *buffer_pool_manager) {
   page_id_t parent_id = GetParentPageId();
-  assert(parent_id == recipient->GetParentPageId());
-  assert(parent_id != INVALID_PAGE_ID);
-  assert(GetSize() > 0 && recipient->GetSize() > 0);
-
-  auto parent_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager->FetchPage(parent_id)->GetData());
-  int this_index = parent_page->ValueIndex(GetPageId());
-  int recipient_index = parent_page->ValueIndex(recipient->GetPageId());
-  assert(this_index != -1 && recipient_index != -1 && this_index - 1 == recipient_index);
-
-  recipient->CopyLastFrom({parent_page->KeyAt(this_index), array[0].second}, buffer_pool_manager);
-
-  // just for removing the warnings
-  if (this_index > recipient_index)
-    parent_page->SetKeyAt(this_index, array[1].first);
-
-  memmove(array, array + 1, (GetSize() - 1) * sizeof(MappingType));
-  IncreaseSize(-1);
-  buffer_pool_manager->UnpinPage(parent_page->GetPageId(), true);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
-    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
-  // move to the end and increase
-  array[GetSize()] = pair;
-  IncreaseSize(1);
-
-  auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(pair.second)->GetData());
-  child_page->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
-}
-
-/*
- * Remove the last key & value pair from this page to head of "recipient"
- * page, then update relavent key & value pair in its parent page.
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeInternalPage *recipient, int,
-    BufferPoolManager *buffer_pool_manager) {
-  page_id_t parent_id = recipient->GetParentPageId();
-  assert(parent_id == GetParentPageId());
+  assert(parent_id == sibling->GetParentPageId());
   assert(parent_id != INVALID_PAGE_ID);
-  assert(GetSize() > 0 && recipient->GetSize() > 0);
 
   auto parent_page = reinterpret_cast<BPlusTreeInternalPage *>(buffer_pool_manager->FetchPage(parent_id)->GetData());
-  int this_index = parent_page->ValueIndex(GetPageId());
-  int recipient_index = parent_page->ValueIndex(recipient->GetPageId());
-
-  assert(this_index != -1 && recipient_index != -1 && recipient_index == this_index + 1);
-  recipient->CopyFirstFrom({parent_page->KeyAt(recipient_index), array[GetSize() - 1].second},
-                           recipient_index,
-                           buffer_pool_manager);
-
-  // just for removing the warnings
-
-  if (this_index + 1 == recipient_index)
-    parent_page->SetKeyAt(recipient_index, array[GetSize() - 1].first);
-
-  IncreaseSize(-1);
-  buffer_pool_manager->UnpinPage(parent_id, true);
-}
-
-// TODO(Handora): why we need parent index?
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &pair, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {
-
-  memmove(array + 1, array, GetSize() * sizeof(MappingType));
-  array[1].first = pair.first;
-  array[0].second = pair.second;
-  auto child_page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager->FetchPage(pair.second)->GetData());
-  child_page->SetParentPageId(GetPageId());
-  IncreaseSize(1);
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  int index = parent_page->ValueIndex(sibling->GetPageId());
+  assert(index > 0);
+
+  std::vector<MappingType> items, sibling_items;
+  GetItems(items);
+  sibling->GetItems(sibling_items);
+  sibling_items[0].first = parent_page->KeyAt(index);
+  items.insert(items.end(), sibling_items.begin(), sibling_items.end());
+  int size = static_cast<int>(items.size());
+  int old_size = GetSize();
+  int middle = SplitIndex(items.data(), size);
+  bool moved = middle != old_size &&
+               parent_page->CanSetKeyAt(index, items[middle].first);
+  if (moved) {
+    CopyFrom(items.data(), middle);
+    sibling->CopyFrom(items.data() + middle, size - middle);
+    if (middle > old_size) {
+      Adopt(old_size, middle, buffer_pool_manager);
+    } else {
+      sibling->Adopt(0, old_size - middle, buffer_pool_manager);
+    }
+    parent_page->SetKeyAt(index, items[middle].first);
+  }
+  buffer_pool_manager->UnpinPage(parent_id, moved);
+  return moved;
 }
 
 /*****************************************************************************
@@ -335,7 +493,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::QueueUpChildren(
     std::queue<BPlusTreePage *> *queue,
     BufferPoolManager *buffer_pool_manager) {
   for (int i = 0; i < GetSize(); i++) {
-    auto *page = buffer_pool_manager->FetchPage(array[i].second);
+    auto *page = buffer_pool_manager->FetchPage(ValueAt(i));
     if (page == nullptr)
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
@@ -365,9 +523,9 @@ std::string B_PLUS_TREE_INTERNAL_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       os << " ";
     }
-    os << std::dec << array[entry].first.ToString();
+    os << std::dec << KeyAt(entry).ToString();
     if (verbose) {
-      os << "(" << array[entry].second << ")";
+      os << "(" << ValueAt(entry) << ")";
     }
     ++entry;
   }
@@ -379,9 +537,21 @@ bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CheckIntegrity(std::shared_ptr<KeyType> low
                                                     std::shared_ptr<KeyType> higher_bound,
                                                     const KeyComparator &comparator,
                                                     BufferPoolManager *buffer_pool_manager) const {
+  if (GetSize() == 0) {
+    LOG_DEBUG("internal page without children");
+    return false;
+  }
+  if (GetFreeSpace() < 0) {
+    LOG_DEBUG("pairs overlap the offsets");
+    return false;
+  }
+  if (GetSize() == 1) {
+    return true;
+  }
+
   // for key[x] value[x] key[x+1]
   // for each K in value[x], key[x] <= K < key[x+1]
-  KeyType prev_key = array[1].first;
+  KeyType prev_key = KeyAt(1);
 
   if (lower_bound != nullptr && comparator(*lower_bound, prev_key) > 0) {
     LOG_DEBUG("less than lower bound");
@@ -389,11 +559,12 @@ bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CheckIntegrity(std::shared_ptr<KeyType> low
   }
 
   for (int i = 2; i < GetSize(); i++) {
-    if (comparator(prev_key, array[i].first) >= 0) {
+    KeyType key = KeyAt(i);
+    if (comparator(prev_key, key) >= 0) {
       LOG_DEBUG("less or equal than prev one");
       return false;
     }
-    prev_key = array[i].first;
+    prev_key = key;
   }
 
   if (higher_bound != nullptr && comparator(prev_key, *higher_bound) >= 0) {
@@ -401,11 +572,6 @@ bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CheckIntegrity(std::shared_ptr<KeyType> low
     return false;
   }
 
-  if (!IsRootPage() && GetSize() < GetMaxSize() / 2) {
-    LOG_DEBUG("non-root page less than half of max size");
-    return false;
-  }
-
   return true;
 }
 
@@ -420,4 +586,8 @@ template class BPlusTreeInternalPage<GenericKey<32>, page_id_t,
                                      GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t,
                                      GenericComparator<64>>;
+template class BPlusTreeInternalPage<GenericKey<128>, page_id_t,
+                                     GenericComparator<128>>;
+template class BPlusTreeInternalPage<GenericKey<256>, page_id_t,
+                                     GenericComparator<256>>;
 } // namespace cmudb
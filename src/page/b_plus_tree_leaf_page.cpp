@@ -2,6 +2,7 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
@@ -19,7 +20,7 @@ namespace cmudb {
 /**
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
- * next page id and set max size
+ * next page id and set max size (the pairs with full-width keys that fit)
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
@@ -28,7 +29,92 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
   SetSize(0);
   SetPageType(IndexPageType::LEAF_PAGE);
   next_page_id_ = INVALID_PAGE_ID;
-  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeLeafPage)) / (sizeof(KeyType) + sizeof(ValueType)));
+  prefix_size_ = 0;
+  SetMaxSize(Capacity() / MaxEntrySize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::Capacity() {
+  return PAGE_SIZE - sizeof(BPlusTreeLeafPage);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::MaxEntrySize() {
+  return sizeof(uint16_t) + sizeof(ValueType) + sizeof(KeyType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::SpaceFor(int count, int suffix_size,
+										 int prefix_size) {
+  if (count == 0) {
+	return 0;
+  }
+  return prefix_size + count * (sizeof(uint16_t) + sizeof(ValueType)) + suffix_size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::SpaceFor(const MappingType *begin,
+										 const MappingType *end) {
+  if (begin == end) {
+	return 0;
+  }
+  int prefix_size = CommonPrefix(begin->first, (end - 1)->first);
+  int suffix_size = 0;
+  for (const MappingType *item = begin; item != end; item++) {
+	suffix_size += std::max(0, KeyLength(item->first) - prefix_size);
+  }
+  return SpaceFor(static_cast<int>(end - begin), suffix_size, prefix_size);
+}
+
+/*
+ * The prefix of the first i pairs only gets shorter as i grows, the suffixes
+ * are summed again each time it does: at most sizeof(KeyType) times
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Spaces(const MappingType *items, int size,
+										bool reverse,
+										std::vector<int> &spaces) {
+  auto key_at = [&](int i) -> const KeyType & {
+	return items[reverse ? size - 1 - i : i].first;
+  };
+  spaces.assign(size + 1, 0);
+  int prefix_size = sizeof(KeyType);
+  int suffix_size = 0;
+  for (int i = 0; i < size; i++) {
+	int common = CommonPrefix(key_at(0), key_at(i));
+	if (common < prefix_size) {
+	  prefix_size = common;
+	  suffix_size = 0;
+	  for (int j = 0; j < i; j++) {
+		suffix_size += std::max(0, KeyLength(key_at(j)) - prefix_size);
+	  }
+	}
+	suffix_size += std::max(0, KeyLength(key_at(i)) - prefix_size);
+	spaces[i + 1] = SpaceFor(i + 1, suffix_size, prefix_size);
+  }
+}
+
+/*
+ * Index of the first pair of the second page when splitting the "size" sorted
+ * pairs at items (at least two), so that the fuller page takes as few bytes
+ * as possible
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::SplitIndex(const MappingType *items, int size) {
+  assert(size >= 2);
+  std::vector<int> first, last;
+  Spaces(items, size, false, first);
+  Spaces(items, size, true, last);
+  int middle = 1;
+  int space = INT_MAX;
+  for (int i = 1; i < size; i++) {
+	int larger = std::max(first[i], last[size - i]);
+	if (larger < space) {
+	  space = larger;
+	  middle = i;
+	}
+  }
+  return middle;
 }
 
 /**
@@ -44,32 +130,69 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
   next_page_id_ = next_page_id;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PairsEnd() const {
+  return PAGE_SIZE - prefix_size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PairEnd(int index) const {
+  return index == 0 ? PairsEnd() : offsets_[index - 1];
+}
+
+/*
+ * Bytes between the offsets and the pairs
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::GetFreeSpace() const {
+  int pairs_begin = PairEnd(GetSize());
+  return pairs_begin - static_cast<int>(sizeof(BPlusTreeLeafPage)) -
+		 GetSize() * static_cast<int>(sizeof(uint16_t));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderfull() const {
+  return GetFreeSpace() > Capacity() - Capacity() / 2;
+}
+
 /**
- * Helper method to find the first index i so that array[i].first >= key
- * NOTE: This method is only used when generating index iterator
+ * Helper method to find the first index i so that KeyAt(i) >= key (binary
+ * search), -1 if every key is smaller
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
     const KeyType &key, const KeyComparator &comparator) const {
-
-  for (int i = 0; i < GetSize(); ++i) {
-	if (comparator(array[i].first, key) >= 0) {
-	  return i;
-	}
-  }
-  return -1;
+  int index = PartitionPoint(offsets_, GetSize(), [&](const uint16_t &offset) {
+	return comparator(KeyAt(static_cast<int>(&offset - offsets_)), key) < 0;
+  });
+  return index == GetSize() ? -1 : index;
 }
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
- * array offset)
+ * array offset): the prefix, the suffix, then zeros
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
   assert(index >= 0 && index < GetSize());
 
-  return array[index].first;
+  const char *data = reinterpret_cast<const char *>(this);
+  KeyType key;
+  char *key_data = reinterpret_cast<char *>(&key);
+  memset(key_data, 0, sizeof(KeyType));
+  memcpy(key_data, data + PairsEnd(), prefix_size_);
+  int suffix_begin = offsets_[index] + sizeof(ValueType);
+  memcpy(key_data + prefix_size_, data + suffix_begin,
+		 PairEnd(index) - suffix_begin);
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const {
+  ValueType value;
+  memcpy(&value, reinterpret_cast<const char *>(this) + offsets_[index],
+		 sizeof(ValueType));
+  return value;
 }
 
 /*
@@ -77,40 +200,128 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
   assert(index >= 0 && index < GetSize());
 
-  return array[index];
+  return std::make_pair(KeyAt(index), ValueAt(index));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::GetItems(std::vector<MappingType> &items) const {
+  items.clear();
+  items.reserve(GetSize() + 1);
+  for (int i = 0; i < GetSize(); i++) {
+	items.push_back(GetItem(i));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PrefixOf(const KeyType &key) const {
+  const char *prefix = reinterpret_cast<const char *>(this) + PairsEnd();
+  const char *key_data = reinterpret_cast<const char *>(&key);
+  int length = 0;
+  while (length < prefix_size_ && prefix[length] == key_data[length]) {
+	length++;
+  }
+  return length;
 }
 
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 /*
- * Insert key & value pair into leaf page ordered by key
+ * Whether key fits on this page. The prefix gets shorter if key doesn't start
+ * with it, and the suffixes of the other keys at most that much longer
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanInsert(const KeyType &key) const {
+  if (GetSize() == 0) {
+	return true;
+  }
+  int common = PrefixOf(key);
+  int entry_size = sizeof(uint16_t) + sizeof(ValueType) +
+				   std::max(0, KeyLength(key) - common);
+  if (common == prefix_size_) {
+	return GetFreeSpace() >= entry_size;
+  }
+  int used = Capacity() - GetFreeSpace();
+  int space = used - prefix_size_ + common +
+			  GetSize() * (prefix_size_ - common) + entry_size;
+  return space <= Capacity();
+}
+
+/*
+ * Put key & value pair at index, moving the following pairs down. key must
+ * start with the prefix and fit
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key,
+										  const ValueType &value) {
+  char *data = reinterpret_cast<char *>(this);
+  int suffix_size = std::max(0, KeyLength(key) - prefix_size_);
+  int entry_size = sizeof(ValueType) + suffix_size;
+  assert(GetFreeSpace() >= entry_size + static_cast<int>(sizeof(uint16_t)));
+
+  int pairs_begin = PairEnd(GetSize());
+  int end = PairEnd(index);
+  memmove(data + pairs_begin - entry_size, data + pairs_begin, end - pairs_begin);
+  for (int i = GetSize(); i > index; i--) {
+	offsets_[i] = offsets_[i - 1] - entry_size;
+  }
+  offsets_[index] = end - entry_size;
+  memcpy(data + offsets_[index], &value, sizeof(ValueType));
+  memcpy(data + offsets_[index] + sizeof(ValueType),
+		 reinterpret_cast<const char *>(&key) + prefix_size_, suffix_size);
+  IncreaseSize(1);
+}
+
+/*
+ * Replace every pair with the "size" ones at items, in ascending key order,
+ * under the longest prefix they share. They must fit
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFrom(const MappingType *items, int size) {
+  assert(SpaceFor(items, items + size) <= Capacity());
+  SetSize(0);
+  prefix_size_ = 0;
+  if (size > 0) {
+	prefix_size_ = CommonPrefix(items[0].first, items[size - 1].first);
+	memcpy(reinterpret_cast<char *>(this) + PairsEnd(), &items[0].first,
+		   prefix_size_);
+  }
+  for (int i = 0; i < size; i++) {
+	InsertAt(i, items[i].first, items[i].second);
+  }
+}
+
+/*
+ * Insert key & value pair into leaf page ordered by key, the caller makes
+ * sure it fits (CanInsert)
  * @return  page size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
 									   const ValueType &value,
 									   const KeyComparator &comparator) {
-  assert(GetSize() < GetMaxSize());
-
   int key_index = KeyIndex(key, comparator);
 
   // the index only support unique key
   if (key_index == -1) {
 	key_index = GetSize();
+  } else if (comparator(KeyAt(key_index), key) == 0) {
+	return GetSize();
+  }
+  assert(CanInsert(key));
+
+  if (GetSize() == 0 || PrefixOf(key) < prefix_size_) {
+	// the prefix changes, so does every suffix
+	std::vector<MappingType> items;
+	GetItems(items);
+	items.insert(items.begin() + key_index, std::make_pair(key, value));
+	CopyFrom(items.data(), static_cast<int>(items.size()));
   } else {
-	if (comparator(KeyAt(key_index), key) == 0) {
-	  return GetSize();
-	}
-	memmove(array + key_index + 1, array + key_index, (GetSize() - key_index) * sizeof(MappingType));
+	InsertAt(key_index, key, value);
   }
-
-  array[key_index] = {key, value};
-  IncreaseSize(1);
   return GetSize();
 }
 
@@ -118,25 +329,29 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Insert key & value pair, then move the pairs after the split point to the
+ * brand-new "recipient" page: both pages end up taking about as many bytes
+ * @return: the shortest key separating the two pages, for their parent
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
-	BPlusTreeLeafPage *recipient,
-	BufferPoolManager *) {
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAndMoveHalfTo(
+	const KeyType &key, const ValueType &value,
+	BPlusTreeLeafPage *recipient, const KeyComparator &comparator) {
+  std::vector<MappingType> items;
+  GetItems(items);
+  int key_index = KeyIndex(key, comparator);
+  if (key_index == -1) {
+	key_index = GetSize();
+  }
+  items.insert(items.begin() + key_index, std::make_pair(key, value));
 
-  int origin_size = GetSize();
-  SetSize(GetSize() / 2);
-  recipient->CopyHalfFrom(array + GetSize(), origin_size - GetSize());
+  int size = static_cast<int>(items.size());
+  int middle = SplitIndex(items.data(), size);
+  CopyFrom(items.data(), middle);
+  recipient->CopyFrom(items.data() + middle, size - middle);
   recipient->SetNextPageId(GetNextPageId());
   SetNextPageId(recipient->GetPageId());
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {
-  // move to a brand-new page
-  memmove(array, items, size * sizeof(MappingType));
-  IncreaseSize(size);
+  return Separator(items[middle - 1].first, items[middle].first);
 }
 
 /*****************************************************************************
@@ -150,20 +365,97 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
 										const KeyComparator &comparator) const {
-  for (int i = 0; i < GetSize(); ++i) {
+  int index = KeyIndex(key, comparator);
+  if (index == -1 || comparator(key, KeyAt(index)) != 0) {
+	return false;
+  }
+  value = ValueAt(index);
+  return true;
+}
 
-	if (comparator(key, array[i].first) == 0) {
-	  value = array[i].second;
-	  return true;
+/*
+ * Lookup for a reader that doesn't latch the page (see
+ * BPlusTree::GetValueOptimistic), while a writer may be changing it. The
+ * size, the prefix and every offset are checked before they are used, so a
+ * page caught half written is still read within its bounds, and nothing but
+ * the pairs the binary search visits is read.
+ * @return: false if the page is not consistent; otherwise found tells
+ * whether key exists, and value is its value. Neither is to be trusted
+ * before the version of the page is validated
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::LookupOptimistic(
+	const KeyType &key, ValueType &value, bool &found,
+	const KeyComparator &comparator) const {
+  const int key_size = static_cast<int>(sizeof(KeyType));
+  const int value_size = static_cast<int>(sizeof(ValueType));
+  int size = GetSize();
+  int prefix_size = prefix_size_;
+  int pairs_end = PAGE_SIZE - prefix_size;
+  if (size < 0 || prefix_size > key_size ||
+	  size > (pairs_end - static_cast<int>(sizeof(BPlusTreeLeafPage))) /
+				 static_cast<int>(sizeof(uint16_t))) {
+	return false;
+  }
+  int offsets_end = sizeof(BPlusTreeLeafPage) + size * sizeof(uint16_t);
+  const char *data = reinterpret_cast<const char *>(this);
+
+  // the key of pair index into other and where the pair begins, unless the
+  // pair is out of bounds
+  bool consistent = true;
+  KeyType other;
+  int pair_begin = 0;
+  auto key_at = [&](int index) {
+	pair_begin = offsets_[index];
+	int pair_end = index == 0 ? pairs_end : offsets_[index - 1];
+	int suffix_size = pair_end - pair_begin - value_size;
+	if (pair_begin < offsets_end || pair_end > pairs_end || suffix_size < 0 ||
+		suffix_size > key_size - prefix_size) {
+	  consistent = false;
+	  return false;
 	}
+	char *key_data = reinterpret_cast<char *>(&other);
+	memcpy(key_data, data + pairs_end, prefix_size);
+	memcpy(key_data + prefix_size, data + pair_begin + value_size, suffix_size);
+	memset(key_data + prefix_size + suffix_size, 0,
+		   key_size - prefix_size - suffix_size);
+	return true;
+  };
+  int index = PartitionPoint(offsets_, size, [&](const uint16_t &offset) {
+	return key_at(static_cast<int>(&offset - offsets_)) &&
+		   comparator(other, key) < 0;
+  });
+  found = consistent && index < size && key_at(index) &&
+		  comparator(key, other) == 0;
+  if (found) {
+	memcpy(&value, data + pair_begin, value_size);
   }
-
-  return false;
+  return consistent;
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
+/*
+ * Remove the pair at index, moving the following pairs up. The prefix stays,
+ * whatever the pairs left share
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) {
+  char *data = reinterpret_cast<char *>(this);
+  int begin = offsets_[index];
+  int entry_size = PairEnd(index) - begin;
+  int pairs_begin = PairEnd(GetSize());
+  memmove(data + pairs_begin + entry_size, data + pairs_begin, begin - pairs_begin);
+  for (int i = index; i < GetSize() - 1; i++) {
+	offsets_[i] = offsets_[i + 1] + entry_size;
+  }
+  IncreaseSize(-1);
+  if (GetSize() == 0) {
+	prefix_size_ = 0;
+  }
+}
+
 /**
  * First look through leaf page to see whether delete key exist or not. If
  * exist, perform deletion, otherwise return immdiately.
@@ -173,16 +465,9 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
-
-  if (!IsRootPage())
-	assert(GetSize() >= GetMinSize());
-
-  for (int i = 0; i < GetSize(); ++i) {
-	if (comparator(key, array[i].first) == 0) {
-	  memmove(array + i, array + i + 1, (GetSize() - i - 1) * sizeof(MappingType));
-	  IncreaseSize(-1);
-	  break;
-	}
+  int i = KeyIndex(key, comparator);
+  if (i != -1 && comparator(key, KeyAt(i)) == 0) {
+	RemoveAt(i);
   }
   return GetSize();
 }
@@ -191,16 +476,33 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page, then
- * update next page id
+ * Whether the pairs of "sibling", the next page, fit here as well. The
+ * prefix gets as short as what the first key here and the last one there
+ * share, the suffixes at most that much longer
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanAbsorb(const BPlusTreeLeafPage *sibling,
+										   const KeyType &) const {
+  if (GetSize() == 0 || sibling->GetSize() == 0) {
+	return true;
+  }
+  int common = CommonPrefix(KeyAt(0), sibling->KeyAt(sibling->GetSize() - 1));
+  int space = common;
+  for (const BPlusTreeLeafPage *page : {this, sibling}) {
+	int used = Capacity() - page->GetFreeSpace();
+	space += used - page->prefix_size_ +
+			 page->GetSize() * (page->prefix_size_ - common);
+  }
+  return space <= Capacity();
+}
+
+/*
+ * Remove all of key & value pairs from this page to "recipient" page, the
+ * previous one, then update next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
 										   int, BufferPoolManager *buffer_pool_manager) {
-  // give a restriction that always move from bigger to little
-  // TODO
-  // should this restriction be relaxed?
-
   page_id_t parent_id = GetParentPageId();
   assert(parent_id == recipient->GetParentPageId());
   assert(parent_id != INVALID_PAGE_ID);
@@ -215,91 +517,60 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
   parent_page->Remove(index);
   buffer_pool_manager->UnpinPage(parent_id, true);
 
-  recipient->CopyAllFrom(array, GetSize());
+  std::vector<MappingType> items, own_items;
+  recipient->GetItems(items);
+  GetItems(own_items);
+  items.insert(items.end(), own_items.begin(), own_items.end());
+  recipient->CopyFrom(items.data(), static_cast<int>(items.size()));
   recipient->SetNextPageId(GetNextPageId());
   SetNextPageId(INVALID_PAGE_ID);
   SetSize(0);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(MappingType *items, int size) {
-
-  memmove(array + GetSize(), items, size * sizeof(MappingType));
-  IncreaseSize(size);
+  prefix_size_ = 0;
 }
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
- */
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeLeafPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {
-
-  page_id_t parent_id = GetParentPageId();
-  assert(parent_id == recipient->GetParentPageId());
-  assert(parent_id != INVALID_PAGE_ID);
-
-  recipient->CopyLastFrom(array[0]);
-  memmove(array, array + 1, (GetSize() - 1) * sizeof(MappingType));
-  IncreaseSize(-1);
-
-  auto parent_page =
-	  reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(buffer_pool_manager->FetchPage(
-		  parent_id)->GetData());
-  int index = parent_page->ValueIndex(GetPageId());
-  parent_page->SetKeyAt(index, array[0].first);
-  buffer_pool_manager->UnpinPage(parent_id, true);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
-  array[GetSize()] = item;
-  IncreaseSize(1);
-}
-/*
- * Remove the last key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Move pairs between this page and "sibling", the next one, so that both
+ * take about as many bytes, then update the key of sibling in their parent
+ * page.
+ * @return: false if nothing moved, the pages being as balanced as they get
+ * or the new key not fitting in the parent
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeLeafPage *recipient, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {
-
-  page_id_t parent_id = GetParentPageId();
-  assert(parent_id == recipient->GetParentPageId());
-  assert(parent_id != INVALID_PAGE_ID);
-  auto parent_page =
-	  reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(buffer_pool_manager->FetchPage(
-		  parent_id)->GetData());
-  int index = parent_page->ValueIndex(recipient->GetPageId());
-  recipient->CopyFirstFrom(array[GetSize() - 1], index, buffer_pool_manager);
-  IncreaseSize(-1);
-  buffer_pool_manager->UnpinPage(parent_id, true);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &item, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {
-
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Redistribute(
+	BPlusTreeLeafPage *sibling, BufferPoolManager *buffer_pool_manager) {
   page_id_t parent_id = GetParentPageId();
+  assert(parent_id == sibling->GetParentPageId());
   assert(parent_id != INVALID_PAGE_ID);
 
-  // move the item to the first of the array and increase the size
-  memmove(array + 1, array, GetSize() * sizeof(MappingType));
-  array[0] = item;
-  IncreaseSize(1);
+  std::vector<MappingType> items, sibling_items;
+  GetItems(items);
+  sibling->GetItems(sibling_items);
+  items.insert(items.end(), sibling_items.begin(), sibling_items.end());
+  int size = static_cast<int>(items.size());
+  if (size < 2) {
+	return false;
+  }
+  int middle = SplitIndex(items.data(), size);
+  if (middle == GetSize()) {
+	return false;
+  }
 
+  KeyType separator = Separator(items[middle - 1].first, items[middle].first);
   auto parent_page =
 	  reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(buffer_pool_manager->FetchPage(
 		  parent_id)->GetData());
-  parent_page->SetKeyAt(parentIndex, array[0].first);
-  buffer_pool_manager->UnpinPage(parent_id, true);
+  int index = parent_page->ValueIndex(sibling->GetPageId());
+  bool moved = parent_page->CanSetKeyAt(index, separator);
+  if (moved) {
+	CopyFrom(items.data(), middle);
+	sibling->CopyFrom(items.data() + middle, size - middle);
+	parent_page->SetKeyAt(index, separator);
+  }
+  buffer_pool_manager->UnpinPage(parent_id, moved);
+  return moved;
 }
 
 /*****************************************************************************
@@ -326,9 +597,9 @@ std::string B_PLUS_TREE_LEAF_PAGE_TYPE::ToString(bool verbose) const {
 	} else {
 	  stream << " ";
 	}
-	stream << std::dec << array[entry].first;
+	stream << std::dec << KeyAt(entry);
 	if (verbose) {
-	  stream << "(" << array[entry].second << ")";
+	  stream << "(" << ValueAt(entry) << ")";
 	}
 	++entry;
   }
@@ -343,37 +614,38 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::CheckIntegrity(std::shared_ptr<KeyType> lower_b
 												std::shared_ptr<KeyType> higher_bound,
 												const KeyComparator &comparator,
 												BufferPoolManager *buffer_pool_manager) const {
-  // for key[x] value[x] key[x+1]
-  // for each K in value[x], key[x] <= K < key[x+1]
-  KeyType prev_key = array[1].first;
+  // 1. only the root may be empty, and the pairs fit
+  if (GetSize() == 0) {
+	return IsRootPage();
+  }
+  if (GetFreeSpace() < 0) {
+	LOG_DEBUG("pairs overlap the offsets");
+	return false;
+  }
 
-  // 1. all keys in the page is larger than the lower bounder
+  // 2. all keys in the page is larger than the lower bounder
+  KeyType prev_key = KeyAt(0);
   if (lower_bound != nullptr && comparator(*lower_bound, prev_key) > 0) {
 	LOG_DEBUG("lower than lower bound");
 	return false;
   }
 
-  // 2. keys is in sorted order
-  for (int i = 2; i < GetSize(); i++) {
-	if (comparator(prev_key, array[i].first) >= 0) {
+  // 3. keys is in sorted order
+  for (int i = 1; i < GetSize(); i++) {
+	KeyType key = KeyAt(i);
+	if (comparator(prev_key, key) >= 0) {
 	  LOG_DEBUG("lower than the prev one");
 	  return false;
 	}
-	prev_key = array[i].first;
+	prev_key = key;
   }
 
-  // 3. all keys in the page is smaller than the higher bounder
+  // 4. all keys in the page is smaller than the higher bounder
   if (higher_bound != nullptr && comparator(prev_key, *higher_bound) >= 0) {
 	LOG_DEBUG("higher than higher bound");
 	return false;
   }
 
-  // 4. check the size constraints
-  if (!IsRootPage() && GetSize() < GetMaxSize() / 2) {
-	LOG_DEBUG("lower than half size");
-	return false;
-  }
-
   return true;
 }
 
@@ -392,4 +664,10 @@ class BPlusTreeLeafPage<GenericKey<32>, RID,
 template
 class BPlusTreeLeafPage<GenericKey<64>, RID,
 						GenericComparator<64>>;
+template
+class BPlusTreeLeafPage<GenericKey<128>, RID,
+						GenericComparator<128>>;
+template
+class BPlusTreeLeafPage<GenericKey<256>, RID,
+						GenericComparator<256>>;
 } // namespace cmudb
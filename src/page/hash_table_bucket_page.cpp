@@ -0,0 +1,132 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+
+#include <cassert>
+
+#include "common/rid.h"
+#include "page/hash_table_bucket_page.h"
+
+namespace cmudb {
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+
+/**
+ * Init method after creating a new bucket page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Init(page_id_t page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  size_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_PAGE_TYPE::GetPageId() const { return page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetSize() const { return size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetMaxSize() const {
+  return (PAGE_SIZE - sizeof(HashTableBucketPage)) / sizeof(MappingType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsFull() const {
+  return size_ >= GetMaxSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsEmpty() const { return size_ == 0; }
+
+/**
+ * Helper methods to set/get next overflow page id
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType HASH_TABLE_BUCKET_PAGE_TYPE::KeyAt(int index) const {
+  assert(index >= 0 && index < size_);
+  return array[index].first;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &HASH_TABLE_BUCKET_PAGE_TYPE::GetItem(int index) const {
+  assert(index >= 0 && index < size_);
+  return array[index];
+}
+
+/*****************************************************************************
+ * LOOKUP, INSERTION AND REMOVAL
+ *****************************************************************************/
+/*
+ * For the given key, check to see whether it exists in this page. If it does,
+ * store its corresponding value in input "value" and return true
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Lookup(
+    const KeyType &key, ValueType &value,
+    const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; ++i) {
+    if (comparator(array[i].first, key) == 0) {
+      value = array[i].second;
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Insert(const KeyType &key,
+                                         const ValueType &value) {
+  assert(!IsFull());
+  array[size_].first = key;
+  array[size_].second = value;
+  size_++;
+}
+
+/*
+ * Remove key if it exists, the last pair fills the hole
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Remove(const KeyType &key,
+                                         const KeyComparator &comparator) {
+  for (int i = 0; i < size_; ++i) {
+    if (comparator(array[i].first, key) == 0) {
+      RemoveAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::RemoveAt(int index) {
+  assert(index >= 0 && index < size_);
+  array[index] = array[size_ - 1];
+  size_--;
+}
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBucketPage<GenericKey<128>, RID, GenericComparator<128>>;
+template class HashTableBucketPage<GenericKey<256>, RID, GenericComparator<256>>;
+} // namespace cmudb
@@ -2,12 +2,57 @@
  * header_page.cpp
  */
 #include <cassert>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "page/header_page.h"
 
 namespace cmudb {
 
+// identifies a database file, in its first 4 bytes
+static const uint32_t FILE_MAGIC = 0x62646d63; // "cmdb"
+
+// where the checkpoint location is kept, records must stay below it
+static inline int TailOffset(int page_size) { return page_size - 8; }
+
+/**
+ * File header page
+ */
+void FileHeaderPage::Init() {
+  memcpy(GetData(), &FILE_MAGIC, 4);
+  memcpy(GetData() + 4, &PAGE_SIZE, 4);
+}
+
+int FileHeaderPage::GetPageSize() {
+  return *reinterpret_cast<int *>(GetData() + 4);
+}
+
+int FileHeaderPage::ReadPageSize(const std::string &db_file) {
+  struct stat stat_buf;
+  if (stat(db_file.c_str(), &stat_buf) != 0 || stat_buf.st_size == 0) {
+    return 0;
+  }
+  int fd = open(db_file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return -1;
+  }
+  char header[8];
+  ssize_t read_count = pread(fd, header, sizeof(header), 0);
+  close(fd);
+  uint32_t magic;
+  int page_size;
+  memcpy(&magic, header, 4);
+  memcpy(&page_size, header + 4, 4);
+  if (read_count != sizeof(header) || magic != FILE_MAGIC ||
+      page_size < MIN_PAGE_SIZE || page_size > MAX_PAGE_SIZE ||
+      (page_size & (page_size - 1)) != 0) {
+    return -1;
+  }
+  return page_size;
+}
+
 /**
  * Record related
  */
@@ -21,6 +66,9 @@ bool HeaderPage::InsertRecord(const std::string &name,
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // check for free space
+  if (offset + 36 > TailOffset(PAGE_SIZE))
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -73,6 +121,22 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   return true;
 }
 
+/**
+ * Checkpoint related
+ */
+void HeaderPage::SetCheckpoint(lsn_t lsn, int log_offset) {
+  memcpy(GetData() + TailOffset(PAGE_SIZE), &lsn, 4);
+  memcpy(GetData() + TailOffset(PAGE_SIZE) + 4, &log_offset, 4);
+}
+
+lsn_t HeaderPage::GetCheckpointLSN() {
+  return *reinterpret_cast<lsn_t *>(GetData() + TailOffset(PAGE_SIZE));
+}
+
+int HeaderPage::GetCheckpointOffset() {
+  return *reinterpret_cast<int *>(GetData() + TailOffset(PAGE_SIZE) + 4);
+}
+
 /**
  * helper functions
  */
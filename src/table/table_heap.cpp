@@ -23,7 +23,8 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       log_manager_(log_manager) {
   auto first_page =
-      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_,
+                                                             &extent_));
   assert(first_page != nullptr); // todo: abort table creation?
   first_page->WLatch();
   LOG_DEBUG("new table page created %d", first_page_id_);
@@ -59,7 +60,8 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
       cur_page->WLatch();
     } else { // create new page
       auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
+          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id,
+                                                                 &extent_));
       if (new_page == nullptr) {
         cur_page->WUnlatch();
         buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
@@ -154,8 +156,30 @@ bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
   return res;
 }
 
+/*
+ * Hand every page of the heap back to the disk manager, following the chain
+ * from the first page. The heap must not be used afterwards
+ * @return: false if a page couldn't be deleted (still pinned), the rest of the
+ * chain from it is left in place
+ */
 bool TableHeap::DeleteTableHeap() {
-  // todo: real delete
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      return false;
+    }
+    page->RLatch();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      return false;
+    }
+    page_id = next_page_id;
+  }
+  first_page_id_ = INVALID_PAGE_ID;
   return true;
 }
 
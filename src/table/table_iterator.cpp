@@ -2,6 +2,7 @@
  * table_iterator.cpp
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include "table/table_heap.h"
@@ -27,8 +28,9 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  page_id_t prev_page_id = tuple_->rid_.GetPageId();
   auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+      buffer_pool_manager->FetchPage(prev_page_id));
   cur_page->RLatch();
   assert(cur_page != nullptr); // all pages are pinned
 
@@ -52,11 +54,55 @@ TableIterator &TableIterator::operator++() {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
   // release until copy the tuple
+  page_id_t page_id = cur_page->GetPageId();
+  page_id_t next_page_id = cur_page->GetNextPageId();
   cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
+  buffer_pool_manager->UnpinPage(page_id, false);
+
+  // the window only moves with the page, and starts with the first one
+  if (*this != table_heap_->end() &&
+      (page_id != prev_page_id || read_ahead_.empty())) {
+    ReadAhead(page_id, next_page_id);
+  }
   return *this;
 }
 
+/*
+ * Keep up to TABLE_READ_AHEAD_PAGES pages after page_id (the current page,
+ * followed by next_page_id) being prefetched. Extending the window needs the
+ * next page id of its last page, so it stops at a page not loaded yet
+ */
+void TableIterator::ReadAhead(page_id_t page_id, page_id_t next_page_id) {
+  // forget the window up to the current page, or all of it if the scan left
+  // the chain it was read ahead on
+  auto cur = std::find(read_ahead_.begin(), read_ahead_.end(), page_id);
+  read_ahead_.erase(read_ahead_.begin(),
+                    cur == read_ahead_.end() ? cur : cur + 1);
+
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  // prefetched pages are unpinned, don't let them evict each other
+  size_t window = std::min<size_t>(TABLE_READ_AHEAD_PAGES,
+                                   buffer_pool_manager->GetPoolSize() / 4);
+  while (read_ahead_.size() < window) {
+    if (!read_ahead_.empty()) {
+      auto last_page = static_cast<TablePage *>(
+          buffer_pool_manager->TryFetchPage(read_ahead_.back()));
+      if (last_page == nullptr) {
+        break;
+      }
+      last_page->RLatch();
+      next_page_id = last_page->GetNextPageId();
+      last_page->RUnlatch();
+      buffer_pool_manager->UnpinPage(last_page->GetPageId(), false);
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    buffer_pool_manager->Prefetch(next_page_id);
+    read_ahead_.push_back(next_page_id);
+  }
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
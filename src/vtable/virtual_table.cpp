@@ -4,7 +4,6 @@
 #include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <sys/stat.h>
 #include <vector>
 
 #include "common/exception.h"
@@ -83,20 +82,25 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   header_page->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
+  page_id_t index_root_id = INVALID_PAGE_ID;
   if (argc > 4) {
     std::string index_string(argv[4]);
     index_string = index_string.substr(1, (index_string.size() - 2));
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    // Retrieve index root page info from header page
-    page_id_t index_root_id;
+    // Retrieve index root page info from header page, none until the index
+    // holds an entry
     header_page->GetRootId(index_metadata->GetName(), index_root_id);
     index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
   }
   VirtualTable *table =
       new VirtualTable(schema, buffer_pool_manager, lock_manager, log_manager,
                        index, table_root_id);
+  // an index without a root may be declared on a table that already has
+  // tuples, build it from them
+  if (index != nullptr && index_root_id == INVALID_PAGE_ID)
+    table->BuildIndex();
 
   // register virtual table within sqlite system
   schema_string = "CREATE TABLE X(" + schema_string + ");";
@@ -258,43 +262,50 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
                sqlite_int64 *pRowid) {
   // LOG_DEBUG("VtabUpdate");
   VirtualTable *table = reinterpret_cast<VirtualTable *>(pVTab);
-  // The single row with rowid equal to argv[0] is deleted
-  if (argc == 1) {
-    const RID rid(sqlite3_value_int64(argv[0]));
-    // delete entry from index
-    table->DeleteEntry(rid);
-    // delete tuple from table heap
-    table->DeleteTuple(rid);
-  }
-  // A new row is inserted with a rowid argv[1] and column values in argv[2] and
-  // following. If argv[1] is an SQL NULL, the a new unique rowid is generated
-  // automatically.
-  else if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
-    Schema *schema = table->GetSchema();
-    Tuple tuple = ConstructTuple(schema, (argv + 2));
-    // insert into table heap
-    RID rid;
-    table->InsertTuple(tuple, rid);
-    // insert into index
-    table->InsertEntry(tuple, rid);
-  }
-  // The row with rowid argv[0] is updated with new values in argv[2] and
-  // following parameters.
-  else if (argc > 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL) {
-    Schema *schema = table->GetSchema();
-    Tuple tuple = ConstructTuple(schema, (argv + 2));
-    RID rid(sqlite3_value_int64(argv[0]));
-    // for update, index always delete and insert
-    // because you have no clue key has been updated or not
-    table->DeleteEntry(rid);
-    // if true, then update succeed, rid keep the same
-    // else, delete & insert
-    if (table->UpdateTuple(tuple, rid) == false) {
+  try {
+    // The single row with rowid equal to argv[0] is deleted
+    if (argc == 1) {
+      const RID rid(sqlite3_value_int64(argv[0]));
+      // delete entry from index
+      table->DeleteEntry(rid);
+      // delete tuple from table heap
       table->DeleteTuple(rid);
-      // rid should be different
+    }
+    // A new row is inserted with a rowid argv[1] and column values in argv[2]
+    // and following. If argv[1] is an SQL NULL, the a new unique rowid is
+    // generated automatically.
+    else if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+      Schema *schema = table->GetSchema();
+      Tuple tuple = ConstructTuple(schema, (argv + 2));
+      // insert into table heap
+      RID rid;
       table->InsertTuple(tuple, rid);
+      // insert into index
+      table->InsertEntry(tuple, rid);
     }
-    table->InsertEntry(tuple, rid);
+    // The row with rowid argv[0] is updated with new values in argv[2] and
+    // following parameters.
+    else if (argc > 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL) {
+      Schema *schema = table->GetSchema();
+      Tuple tuple = ConstructTuple(schema, (argv + 2));
+      RID rid(sqlite3_value_int64(argv[0]));
+      // for update, index always delete and insert
+      // because you have no clue key has been updated or not
+      table->DeleteEntry(rid);
+      // if true, then update succeed, rid keep the same
+      // else, delete & insert
+      if (table->UpdateTuple(tuple, rid) == false) {
+        table->DeleteTuple(rid);
+        // rid should be different
+        table->InsertTuple(tuple, rid);
+      }
+      table->InsertEntry(tuple, rid);
+    }
+  } catch (Exception &e) {
+    // a value the table or its index can't hold
+    sqlite3_free(pVTab->zErrMsg);
+    pVTab->zErrMsg = sqlite3_mprintf("%s", e.what());
+    return SQLITE_CONSTRAINT;
   }
   return SQLITE_OK;
 }
@@ -355,21 +366,16 @@ __declspec(dllexport)
                                        const sqlite3_api_routines *pApi) {
   SQLITE_EXTENSION_INIT2(pApi);
   std::string db_file_name = "vtable.db";
-  struct stat buffer;
-  bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
 
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  // init storage engine, which creates the header pages of a new database
+  try {
+    storage_engine_ = new StorageEngine(db_file_name);
+  } catch (Exception &e) {
+    *pzErrMsg = sqlite3_mprintf("%s", e.what());
+    return SQLITE_ERROR;
+  }
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
-  // create header page from BufferPoolManager if necessary
-  if (!is_file_exist) {
-    page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
-
-    assert(header_page_id == HEADER_PAGE_ID);
-    storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
-  }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
   return rc;
@@ -442,6 +448,7 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   std::string::size_type n;
   std::string index_name;
   std::vector<int> key_attrs;
+  IndexType index_type = IndexType::BPlusTree;
   int column_id = -1;
   // prepocess, transform sql string into lower case
   std::transform(sql.begin(), sql.end(), sql.begin(), ::tolower);
@@ -451,6 +458,19 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   index_name = sql.substr(0, n);
   sql = sql.substr(n + 1);
 
+  // optional trailing "using hash" or "using btree"
+  n = sql.rfind(" using ");
+  if (n != std::string::npos) {
+    std::string method = sql.substr(n + 7);
+    StringUtility::Trim(method);
+    if (method == "hash")
+      index_type = IndexType::Hash;
+    else if (method != "btree")
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't create index, unknown method " + method);
+    sql = sql.substr(0, n);
+  }
+
   std::vector<std::string> tok = StringUtility::Split(sql, ',');
   // iterate through returned result
   for (std::string &t : tok) {
@@ -463,7 +483,7 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, index_type);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -490,10 +510,18 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
     case TypeId::DECIMAL:
       v = Value(type, sqlite3_value_double(argv[i]));
       break;
-    case TypeId::VARCHAR:
-      v = Value(type, std::string(reinterpret_cast<const char *>(
-                          sqlite3_value_text(argv[i]))));
+    case TypeId::VARCHAR: {
+      std::string text(
+          reinterpret_cast<const char *>(sqlite3_value_text(argv[i])));
+      // index keys are sized from the column length
+      if (text.length() > static_cast<size_t>(schema->GetVariableLength(i))) {
+        throw Exception(EXCEPTION_TYPE_CONSTRAINT,
+                        "value too long for column " +
+                            schema->GetColumn(i).GetName());
+      }
+      v = Value(type, text);
       break;
+    }
     default:
       break;
     } // End of switch
@@ -504,31 +532,45 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   return tuple;
 }
 
+// one index of type Index over keys of KeySize bytes
+template <size_t KeySize>
+static Index *ConstructIndexOfSize(IndexMetadata *metadata,
+                                   BufferPoolManager *buffer_pool_manager,
+                                   page_id_t root_id) {
+  if (metadata->GetIndexType() == IndexType::Hash) {
+    return new HashIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>(
+        metadata, buffer_pool_manager, root_id);
+  }
+  return new BPlusTreeIndex<GenericKey<KeySize>, RID,
+                            GenericComparator<KeySize>>(
+      metadata, buffer_pool_manager, root_id);
+}
+
 // serve the functionality of index factory
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
                       page_id_t root_id) {
-  // The size of the key in bytes
-  Schema *key_schema = metadata->GetKeySchema();
-  int key_size = key_schema->GetLength();
-  // for each varchar attribute, we assume the largest size is 16 bytes
-  key_size += 16 * key_schema->GetUnlinedColumnCount();
+  // The size of the key in bytes, varchars are as long as their columns
+  size_t key_size = GetEncodedKeySize(metadata->GetKeySchema());
+  // a tree node must still hold a few keys
+  if (key_size > 256 || key_size > static_cast<size_t>(PAGE_SIZE) / 8) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, key too large");
+  }
 
   if (key_size <= 4) {
-    return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<4>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 8) {
-    return new BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<8>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 16) {
-    return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<16>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 32) {
-    return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<32>(metadata, buffer_pool_manager, root_id);
+  } else if (key_size <= 64) {
+    return ConstructIndexOfSize<64>(metadata, buffer_pool_manager, root_id);
+  } else if (key_size <= 128) {
+    return ConstructIndexOfSize<128>(metadata, buffer_pool_manager, root_id);
   } else {
-    return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<256>(metadata, buffer_pool_manager, root_id);
   }
 }
 
@@ -3,6 +3,12 @@
  */
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -100,4 +106,290 @@ TEST(BufferPoolManagerTest, SampleTest) {
     remove("test.db");
   }
 
+  TEST(BufferPoolManagerTest, PartitionedTest) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    // 4 instances of 5 frames each
+    BufferPoolManager bpm(20, disk_manager, nullptr, 4);
+    EXPECT_EQ(4, bpm.GetNumInstances());
+
+    const int num_threads = 4;
+    const int pages_per_thread = 50;
+    std::vector<std::vector<page_id_t>> page_ids(num_threads);
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.push_back(std::thread([tid, &bpm, &page_ids]() {
+	for (int i = 0; i < pages_per_thread; i++) {
+	  page_id_t page_id;
+	  Page *page = bpm.NewPage(page_id);
+	  // a full instance may refuse the new page, just try again
+	  if (page == nullptr) {
+	    i--;
+	    continue;
+	  }
+	  snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+	  page_ids[tid].push_back(page_id);
+	  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+	}
+      }));
+    }
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads[tid].join();
+    }
+    EXPECT_EQ(0, bpm.PinnedNum());
+
+    // every page must survive eviction from its own instance
+    for (int tid = 0; tid < num_threads; tid++) {
+      for (auto page_id : page_ids[tid]) {
+	Page *page = bpm.FetchPage(page_id);
+	ASSERT_NE(nullptr, page);
+	EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+	EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+      }
+    }
+    EXPECT_EQ(0, bpm.PinnedNum());
+
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, ClockReplacerTest) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(10, disk_manager, nullptr, 2, ReplacerType::CLOCK);
+
+    // twice as many pages as frames, each one evicted and read back
+    for (int i = 0; i < 20; i++) {
+      page_id_t page_id;
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+    }
+    for (int i = 0; i < 20; i++) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(std::to_string(i), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    // a full instance refuses new pages
+    std::vector<page_id_t> pinned;
+    for (int i = 0; i < 10; i++) {
+      page_id_t page_id;
+      EXPECT_NE(nullptr, bpm.NewPage(page_id));
+      pinned.push_back(page_id);
+    }
+    page_id_t page_id;
+    EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+    for (auto id : pinned) {
+      EXPECT_EQ(true, bpm.UnpinPage(id, false));
+    }
+    EXPECT_EQ(0, bpm.PinnedNum());
+
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    // far fewer frames than pages, so most fetches read from disk
+    BufferPoolManager bpm(8, disk_manager, nullptr, 2);
+
+    const int num_pages = 64;
+    const int num_threads = 4;
+    const int fetches_per_thread = 500;
+    // pages are only ever written as "<page_id>:<version>"
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, page_id);
+      snprintf(page->GetData(), PAGE_SIZE, "%d:0", page_id);
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+    }
+
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.push_back(std::thread([tid, &bpm]() {
+	std::mt19937 gen(tid);
+	std::uniform_int_distribution<int> dis(0, num_pages - 1);
+	for (int i = 0; i < fetches_per_thread; i++) {
+	  page_id_t page_id = dis(gen);
+	  Page *page = bpm.FetchPage(page_id);
+	  // every frame may be pinned by other threads
+	  if (page == nullptr)
+	    continue;
+	  EXPECT_EQ(page_id, page->GetPageId());
+	  bool dirty = i % 4 == 0;
+	  if (dirty) {
+	    page->WLatch();
+	    int version = atoi(strchr(page->GetData(), ':') + 1);
+	    snprintf(page->GetData(), PAGE_SIZE, "%d:%d", page_id, version + 1);
+	    page->WUnlatch();
+	  }
+	  page->RLatch();
+	  EXPECT_EQ(page_id, atoi(page->GetData()));
+	  page->RUnlatch();
+	  EXPECT_EQ(true, bpm.UnpinPage(page_id, dirty));
+	}
+      }));
+    }
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads[tid].join();
+    }
+    EXPECT_EQ(0, bpm.PinnedNum());
+
+    // every page survives, whichever thread wrote it back
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, atoi(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, AsyncBatchTest) {
+    const int num_pages = 30;
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+      EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+      page_ids.push_back(temp_page_id);
+    }
+    // the last pages are only in memory, write them back in one batch
+    bpm->WriteBackPages(page_ids);
+    delete bpm;
+
+    bpm = new BufferPoolManager(10, disk_manager);
+    std::vector<page_id_t> prefetch_ids(page_ids.begin(), page_ids.begin() + 8);
+    bpm->PrefetchPages(prefetch_ids);
+    // prefetching again is a no-op for resident pages
+    bpm->PrefetchPages(prefetch_ids);
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, atoi(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+    }
+    EXPECT_EQ(0, bpm->PinnedNum());
+
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, FlusherTest) {
+    const int pool_size = 20;
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    for (auto replacer_type :
+         {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::TWO_Q}) {
+      BufferPoolManager *bpm =
+          new BufferPoolManager(pool_size, disk_manager, nullptr, 1,
+                                replacer_type);
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pool_size; i++) {
+        Page *page = bpm->NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+        EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        page_ids.push_back(temp_page_id);
+      }
+      EXPECT_EQ(pool_size, bpm->DirtyNum());
+
+      // the flusher brings the dirty pages down to the low watermark
+      bpm->RunFlusherThread(0.5, 0.25);
+      for (int i = 0; i < 1000 && bpm->DirtyNum() > pool_size / 4; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      EXPECT_EQ(true, bpm->DirtyNum() <= pool_size / 4);
+
+      // evict everything, whether or not the flusher got to it
+      for (int i = 0; i < pool_size; i++) {
+        ASSERT_NE(nullptr, bpm->NewPage(temp_page_id));
+        EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, false));
+      }
+      for (int i = 0; i < pool_size; i++) {
+        Page *page = bpm->FetchPage(page_ids[i]);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(i, atoi(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+      }
+      bpm->StopFlusherThread();
+      EXPECT_EQ(0, bpm->PinnedNum());
+      delete bpm;
+    }
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, FlusherDeleteTest) {
+    const int pool_size = 20;
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(pool_size, disk_manager);
+    bpm->RunFlusherThread(0.1, 0.05);
+    for (int round = 0; round < 50; round++) {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pool_size; i++) {
+        Page *page = bpm->NewPage(temp_page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+        EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+        page_ids.push_back(temp_page_id);
+      }
+      // pages the flusher is writing out are waited for, not refused
+      for (auto page_id : page_ids) {
+        EXPECT_EQ(true, bpm->DeletePage(page_id));
+      }
+    }
+    bpm->StopFlusherThread();
+    EXPECT_EQ(0, bpm->PinnedNum());
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+
+  TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager, nullptr, 2);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < 10; i++) {
+      Page *page = bpm->NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+      page_ids.push_back(temp_page_id);
+      // pinned pages are written too
+      if (i % 2 == 0) {
+        EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+      }
+    }
+    bpm->FlushAllPages();
+    EXPECT_EQ(0, bpm->DirtyNum());
+    EXPECT_EQ(5, bpm->PinnedNum());
+    for (int i = 1; i < 10; i += 2) {
+      EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+    }
+    delete bpm;
+
+    bpm = new BufferPoolManager(10, disk_manager);
+    for (int i = 0; i < 10; i++) {
+      Page *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(i, atoi(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+    }
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+  }
+
 } // namespace cmudb
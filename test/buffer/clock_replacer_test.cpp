@@ -0,0 +1,145 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer(7, 0);
+
+  // push element into replacer
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // every frame is referenced, the first sweep gives all a second chance
+  int value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+
+  // a referenced frame survives the next sweep
+  clock_replacer.Insert(3);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // pop element from replacer after removal
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, ConcurrentTest) {
+  const int num_threads = 4;
+  const int frames_per_thread = 64;
+  ClockReplacer<int> clock_replacer(num_threads * frames_per_thread, 0);
+
+  // every thread pins and unpins its own frames
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &clock_replacer]() {
+      for (int round = 0; round < 100; round++) {
+	for (int i = 0; i < frames_per_thread; i++) {
+	  int frame = tid * frames_per_thread + i;
+	  clock_replacer.Insert(frame);
+	  if (round % 2 == 0 || i % 2 == 0) {
+	    EXPECT_EQ(true, clock_replacer.Erase(frame));
+	  }
+	}
+      }
+    }));
+  }
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads[tid].join();
+  }
+  // odd frames are left after the last round
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  std::vector<bool> seen(num_threads * frames_per_thread, false);
+  int value;
+  while (clock_replacer.Victim(value)) {
+    EXPECT_EQ(1, value % 2);
+    EXPECT_EQ(false, seen[value]);
+    seen[value] = true;
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+/*
+ * Compare LRU and CLOCK on the buffer pool access pattern: an unpin
+ * (Insert) and a pin (Erase) per page hit, and a Victim per miss
+ */
+static double RunReplacerBenchmark(Replacer<int> &replacer, int num_frames,
+				   int num_threads) {
+  const int ops_per_thread = 200000;
+  for (int i = 0; i < num_frames; i++) {
+    replacer.Insert(i);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, num_frames, num_threads, &replacer]() {
+      // every thread works on its own frames, like pinned pages would
+      int slice = num_frames / num_threads;
+      for (int i = 0; i < ops_per_thread; i++) {
+	int frame = tid * slice + i % slice;
+	if (i % 8 == 0) {
+	  int victim;
+	  if (replacer.Victim(victim))
+	    replacer.Insert(victim);
+	} else {
+	  replacer.Erase(frame);
+	  replacer.Insert(frame);
+	}
+      }
+    }));
+  }
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads[tid].join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+TEST(ClockReplacerTest, BenchmarkTest) {
+  const int num_frames = 1024;
+  for (int num_threads : {1, 4}) {
+    LRUReplacer<int> lru_replacer;
+    ClockReplacer<int> clock_replacer(num_frames, 0);
+    double lru = RunReplacerBenchmark(lru_replacer, num_frames, num_threads);
+    double clock =
+	RunReplacerBenchmark(clock_replacer, num_frames, num_threads);
+    printf("%d thread(s): LRU %.0f ops/s, CLOCK %.0f ops/s\n", num_threads,
+	   lru, clock);
+    EXPECT_EQ(num_frames, lru_replacer.Size());
+    EXPECT_EQ(num_frames, clock_replacer.Size());
+  }
+}
+
+} // namespace cmudb
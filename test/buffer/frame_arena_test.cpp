@@ -0,0 +1,54 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// the arena starts zeroed, aligned on memory pages, and keeps what is written
+static void CheckArena(FrameArena &arena, size_t size) {
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(arena.GetData()) % 4096);
+  EXPECT_LE(size, arena.GetSize());
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_EQ(0, arena.GetData()[i]);
+    if (arena.GetData()[i] != 0)
+      break;
+  }
+  for (size_t i = 0; i < size; i++) {
+    arena.GetData()[i] = static_cast<char>(i * 7);
+  }
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_EQ(static_cast<char>(i * 7), arena.GetData()[i]);
+    if (arena.GetData()[i] != static_cast<char>(i * 7))
+      break;
+  }
+}
+
+TEST(FrameArenaTest, SampleTest) {
+  // smaller than a memory page, then a few huge pages
+  for (size_t size : {1000ul, 3ul * 2 * 1024 * 1024 + 512}) {
+    FrameArena arena(size);
+    CheckArena(arena, size);
+    if (arena.UsesHugePages()) {
+      EXPECT_EQ(0u, arena.GetSize() % (2 * 1024 * 1024));
+    }
+  }
+}
+
+TEST(FrameArenaTest, PlacementTest) {
+  // every machine has a node 0, placement failures are not fatal anyway
+  const size_t size = 4 * 1024 * 1024;
+  FrameArena interleaved(size, true, NumaPolicy::INTERLEAVE);
+  CheckArena(interleaved, size);
+  FrameArena bound(size, true, NumaPolicy::BIND, 0);
+  CheckArena(bound, size);
+  FrameArena invalid(size, false, NumaPolicy::BIND, 1000);
+  CheckArena(invalid, size);
+}
+
+} // namespace cmudb
@@ -3,6 +3,7 @@
  */
 
 #include <cstdio>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
@@ -35,6 +36,15 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(false, lru_replacer.Erase(4));
   EXPECT_EQ(true, lru_replacer.Erase(6));
   EXPECT_EQ(2, lru_replacer.Size());
+
+  // peek at the next victims without removing them
+  std::vector<int> values;
+  lru_replacer.Peek(values, 1);
+  EXPECT_EQ(std::vector<int>{5}, values);
+  values.clear();
+  lru_replacer.Peek(values, 10);
+  EXPECT_EQ((std::vector<int>{5, 1}), values);
+  EXPECT_EQ(2, lru_replacer.Size());
   
   // pop element from replacer after removal
   lru_replacer.Victim(value);
@@ -0,0 +1,109 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageTableTest, SampleTest) {
+  Page frames[10];
+  PageTable page_table(10);
+  EXPECT_EQ(32, page_table.GetCapacity());
+
+  // ids strided like the ones of one instance
+  for (int i = 0; i < 10; i++) {
+    page_table.Insert(i * 4, &frames[i]);
+  }
+  Page *page = nullptr;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(true, page_table.Find(i * 4, page));
+    EXPECT_EQ(&frames[i], page);
+  }
+  EXPECT_EQ(false, page_table.Find(1, page));
+
+  // replace the frame of a page
+  page_table.Insert(8, &frames[0]);
+  EXPECT_EQ(true, page_table.Find(8, page));
+  EXPECT_EQ(&frames[0], page);
+
+  // remove every other page, the rest must stay reachable
+  for (int i = 0; i < 10; i += 2) {
+    EXPECT_EQ(true, page_table.Remove(i * 4));
+    EXPECT_EQ(false, page_table.Remove(i * 4));
+  }
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i % 2 == 1, page_table.Find(i * 4, page));
+  }
+}
+
+TEST(PageTableTest, ChurnTest) {
+  // a full table keeps evicting its oldest page, as a buffer pool does
+  const int num_frames = 64;
+  Page frames[num_frames];
+  PageTable page_table(num_frames);
+  Page *page = nullptr;
+
+  for (int i = 0; i < 100000; i++) {
+    if (i >= num_frames) {
+      EXPECT_EQ(true, page_table.Remove(i - num_frames));
+    }
+    page_table.Insert(i, &frames[i % num_frames]);
+    // every resident page is found, the evicted one is not
+    if (i % 997 == 0) {
+      for (int j = std::max(0, i - num_frames + 1); j <= i; j++) {
+        EXPECT_EQ(true, page_table.Find(j, page));
+        EXPECT_EQ(&frames[j % num_frames], page);
+      }
+      EXPECT_EQ(false, page_table.Find(i - num_frames, page));
+    }
+  }
+}
+
+TEST(PageTableTest, ConcurrentTest) {
+  // readers look up pages that stay resident while a writer churns the rest
+  const int num_frames = 64;
+  const int num_stable = 16;
+  const int num_readers = 4;
+  Page frames[num_frames];
+  PageTable page_table(num_frames);
+  for (int i = 0; i < num_stable; i++) {
+    page_table.Insert(i, &frames[i]);
+  }
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < num_readers; tid++) {
+    readers.push_back(std::thread([&]() {
+      Page *page = nullptr;
+      while (!done) {
+	for (int i = 0; i < num_stable; i++) {
+	  EXPECT_EQ(true, page_table.Find(i, page));
+	  EXPECT_EQ(&frames[i], page);
+	}
+      }
+    }));
+  }
+
+  const int num_churn = num_frames - num_stable;
+  for (int i = 0; i < 200000; i++) {
+    page_id_t page_id = num_stable + i;
+    if (i >= num_churn) {
+      EXPECT_EQ(true, page_table.Remove(page_id - num_churn));
+    }
+    page_table.Insert(page_id, &frames[num_stable + i % num_churn]);
+  }
+  done = true;
+  for (int tid = 0; tid < num_readers; tid++) {
+    readers[tid].join();
+  }
+}
+
+} // namespace cmudb
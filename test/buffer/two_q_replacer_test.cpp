@@ -0,0 +1,144 @@
+/**
+ * two_q_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  // 8 frames: A1in is reclaimed first once it holds 2 pages
+  TwoQReplacer<int> two_q_replacer(8);
+
+  // push element into replacer, a second hit in A1in doesn't promote
+  two_q_replacer.Insert(1);
+  two_q_replacer.Insert(2);
+  two_q_replacer.Insert(3);
+  two_q_replacer.Insert(1);
+  EXPECT_EQ(3, two_q_replacer.Size());
+
+  // pop element from A1in in FIFO order, they are remembered in A1out
+  int value;
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(2, value);
+
+  // 1 and 2 come back into Am, 4 and 5 are new
+  two_q_replacer.Insert(1);
+  two_q_replacer.Insert(2);
+  two_q_replacer.Insert(4);
+  two_q_replacer.Insert(5);
+  two_q_replacer.Insert(1);
+  EXPECT_EQ(5, two_q_replacer.Size());
+
+  // A1in (3, 4, 5) goes first while it holds 2 or more pages
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(4, value);
+
+  // pinned pages are skipped
+  EXPECT_EQ(true, two_q_replacer.Erase(2));
+  EXPECT_EQ(false, two_q_replacer.Erase(2));
+  EXPECT_EQ(false, two_q_replacer.Erase(3));
+  EXPECT_EQ(2, two_q_replacer.Size());
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(true, two_q_replacer.Victim(value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, two_q_replacer.Victim(value));
+
+  // a discarded page leaves no ghost behind
+  two_q_replacer.Insert(2);
+  two_q_replacer.Discard(2);
+  EXPECT_EQ(0, two_q_replacer.Size());
+  EXPECT_EQ(false, two_q_replacer.Victim(value));
+}
+
+/*
+ * Minimal buffer pool over a replacer, counting hits of the index pages
+ */
+class PoolSimulator {
+public:
+  PoolSimulator(Replacer<int> &replacer, size_t num_frames)
+      : replacer_(replacer), num_frames_(num_frames) {}
+
+  // pin then unpin page_id, return true on a hit
+  bool Access(int page_id) {
+    if (resident_.count(page_id)) {
+      replacer_.Erase(page_id);
+      replacer_.Insert(page_id);
+      return true;
+    }
+    if (resident_.size() == num_frames_) {
+      int victim;
+      EXPECT_EQ(true, replacer_.Victim(victim));
+      resident_.erase(victim);
+    }
+    resident_.insert(page_id);
+    replacer_.Insert(page_id);
+    return false;
+  }
+
+private:
+  Replacer<int> &replacer_;
+  size_t num_frames_;
+  std::unordered_set<int> resident_;
+};
+
+/*
+ * Point lookups go through the root and one of the leaves of a small index.
+ * Every lookup is paired with one step of a table scan that visits each heap
+ * page once per tuple, the way TableIterator does
+ */
+static double IndexHitRate(Replacer<int> &replacer, bool with_scan) {
+  const int num_frames = 16;
+  const int num_leaves = 9;
+  const int tuples_per_page = 4;
+  const int num_lookups = 20000;
+  const int root = 0;
+  const int first_heap_page = 1000;
+
+  PoolSimulator pool(replacer, num_frames);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> leaf(1, num_leaves);
+  auto lookup = [&]() { return pool.Access(root) + pool.Access(leaf(gen)); };
+
+  // warm up with lookups only
+  for (int i = 0; i < num_lookups; i++) {
+    lookup();
+  }
+  int hits = 0;
+  for (int i = 0; i < num_lookups; i++) {
+    if (with_scan) {
+      pool.Access(first_heap_page + i / tuples_per_page);
+    }
+    hits += lookup();
+  }
+  return hits / (2.0 * num_lookups);
+}
+
+TEST(TwoQReplacerTest, ScanResistanceTest) {
+  TwoQReplacer<int> two_q_baseline(16), two_q_scan(16);
+  LRUReplacer<int> lru_baseline, lru_scan;
+  double two_q_without = IndexHitRate(two_q_baseline, false);
+  double two_q_with = IndexHitRate(two_q_scan, true);
+  double lru_without = IndexHitRate(lru_baseline, false);
+  double lru_with = IndexHitRate(lru_scan, true);
+  printf("index hit rate without/with scan: 2Q %.4f/%.4f, LRU %.4f/%.4f\n",
+         two_q_without, two_q_with, lru_without, lru_with);
+
+  // the index fits in the pool, the scan must not push it out
+  EXPECT_EQ(1.0, two_q_without);
+  EXPECT_GE(two_q_with, 0.999);
+  EXPECT_LT(lru_with, two_q_with);
+}
+
+} // namespace cmudb
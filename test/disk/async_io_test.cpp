@@ -0,0 +1,86 @@
+/**
+ * async_io_test.cpp
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "disk/async_io.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// write then read back more pages than the queue depth, in batches
+static void ReadWriteBatches(bool use_io_uring) {
+  const int num_pages = 100;
+  int fd = open("test.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_NE(-1, fd);
+  std::vector<std::vector<char>> pages(num_pages,
+                                       std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> buffers(num_pages,
+                                         std::vector<char>(PAGE_SIZE));
+  std::atomic<int> completed(0);
+  std::atomic<int> failed(0);
+  {
+    AsyncIO async_io(fd, 16, use_io_uring);
+    for (int i = 0; i < num_pages; i++) {
+      memset(pages[i].data(), i, PAGE_SIZE);
+      async_io.PrepareWrite(pages[i].data(), PAGE_SIZE, i * PAGE_SIZE,
+                            [&](ssize_t result) {
+                              if (result != PAGE_SIZE)
+                                failed++;
+                              completed++;
+                            });
+    }
+    async_io.Wait();
+    EXPECT_EQ(num_pages, completed);
+
+    for (int i = 0; i < num_pages; i++) {
+      async_io.PrepareRead(buffers[i].data(), PAGE_SIZE, i * PAGE_SIZE,
+                           [&](ssize_t result) {
+                             if (result != PAGE_SIZE)
+                               failed++;
+                             completed++;
+                           });
+      if (i % 10 == 9) {
+        async_io.Submit();
+      }
+    }
+    // the destructor waits for everything in flight
+  }
+  EXPECT_EQ(2 * num_pages, completed);
+  EXPECT_EQ(0, failed);
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_EQ(0, memcmp(pages[i].data(), buffers[i].data(), PAGE_SIZE));
+  }
+
+  // reading past the end of file transfers nothing
+  ssize_t read_count = -1;
+  {
+    AsyncIO async_io(fd, 16, use_io_uring);
+    async_io.PrepareRead(buffers[0].data(), PAGE_SIZE, num_pages * PAGE_SIZE,
+                         [&](ssize_t result) { read_count = result; });
+  }
+  EXPECT_EQ(0, read_count);
+  close(fd);
+  remove("test.db");
+}
+
+TEST(AsyncIOTest, IOUringTest) { ReadWriteBatches(true); }
+
+TEST(AsyncIOTest, ThreadPoolTest) {
+  int fd = open("test.db", O_RDWR | O_CREAT, 0644);
+  ASSERT_NE(-1, fd);
+  {
+    AsyncIO async_io(fd, 16, false);
+    EXPECT_EQ(false, async_io.UsesIOUring());
+  }
+  close(fd);
+  ReadWriteBatches(false);
+}
+
+} // namespace cmudb
@@ -0,0 +1,171 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  for (bool direct_io : {false, true}) {
+    DiskManager *disk_manager = new DiskManager("test.db", direct_io);
+    char data[PAGE_SIZE + 1];
+    char buffer[PAGE_SIZE + 1];
+    // unaligned on purpose, direct I/O must cope with it
+    char *page_data = data + 1;
+    char *page_buffer = buffer + 1;
+
+    for (int i = 0; i < PAGE_SIZE; i++) {
+      page_data[i] = static_cast<char>(i * 7);
+    }
+    disk_manager->WritePage(0, page_data);
+    disk_manager->WritePage(5, page_data);
+    disk_manager->ReadPage(5, page_buffer);
+    EXPECT_EQ(0, memcmp(page_data, page_buffer, PAGE_SIZE));
+
+    // a hole in the file reads back as zeros
+    disk_manager->ReadPage(3, page_buffer);
+    for (int i = 0; i < PAGE_SIZE; i++) {
+      EXPECT_EQ(0, page_buffer[i]);
+    }
+    delete disk_manager;
+
+    // the content and the file size survive reopening
+    disk_manager = new DiskManager("test.db", direct_io);
+    memset(page_buffer, 0, PAGE_SIZE);
+    disk_manager->ReadPage(5, page_buffer);
+    EXPECT_EQ(0, memcmp(page_data, page_buffer, PAGE_SIZE));
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(DiskManagerTest, AllocateTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  char page_data[PAGE_SIZE];
+  memset(page_data, 0, PAGE_SIZE);
+  for (page_id_t i = 0; i < 20; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, page_data);
+  }
+  // freed page ids come back lowest first, then the file grows again
+  disk_manager->DeallocatePage(7);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(3);
+  EXPECT_EQ(false, disk_manager->IsAllocated(3));
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(7, disk_manager->AllocatePage());
+  EXPECT_EQ(20, disk_manager->AllocatePage());
+  EXPECT_EQ(true, disk_manager->IsAllocated(20));
+
+  // freeing the last pages lowers the high-water mark
+  disk_manager->DeallocatePage(20);
+  disk_manager->DeallocatePage(12);
+  disk_manager->DeallocatePage(19);
+  delete disk_manager;
+
+  // the map survives reopening
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(true, disk_manager->IsAllocated(7));
+  EXPECT_EQ(false, disk_manager->IsAllocated(12));
+  EXPECT_EQ(12, disk_manager->AllocatePage());
+  EXPECT_EQ(19, disk_manager->AllocatePage());
+  EXPECT_EQ(20, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // a database without its map keeps every page it holds
+  remove("test.fsm");
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(true, disk_manager->IsAllocated(12));
+  EXPECT_EQ(20, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // a new database starts over, whatever map is left
+  remove("test.db");
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  Extent table_extent, index_extent;
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  // interleaved allocations still give each object contiguous pages
+  for (page_id_t i = 0; i < EXTENT_SIZE; i++) {
+    EXPECT_EQ(1 + i, disk_manager->AllocatePage(&table_extent));
+    EXPECT_EQ(1 + EXTENT_SIZE + i, disk_manager->AllocatePage(&index_extent));
+  }
+  // the next extents follow, other pages skip what is reserved
+  EXPECT_EQ(2 * EXTENT_SIZE + 1, disk_manager->AllocatePage(&table_extent));
+  EXPECT_EQ(3 * EXTENT_SIZE + 1, disk_manager->AllocatePage(&index_extent));
+  EXPECT_EQ(4 * EXTENT_SIZE + 1, disk_manager->AllocatePage());
+  EXPECT_EQ(false, disk_manager->IsAllocated(2 * EXTENT_SIZE + 2));
+
+  // a free run of the map is reused for a new extent
+  Extent other_extent;
+  for (page_id_t i = 1; i <= 2 * EXTENT_SIZE; i++) {
+    disk_manager->DeallocatePage(i);
+  }
+  EXPECT_EQ(8, disk_manager->AllocatePage(&other_extent));
+  EXPECT_EQ(1, disk_manager->AllocatePage());
+  // an empty database would start over
+  char page_data[PAGE_SIZE];
+  memset(page_data, 0, PAGE_SIZE);
+  disk_manager->WritePage(0, page_data);
+  delete disk_manager;
+
+  // reservations are gone after reopening
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(2, disk_manager->AllocatePage());
+  EXPECT_EQ(false, disk_manager->IsAllocated(9));
+  Extent new_extent;
+  EXPECT_EQ(16, disk_manager->AllocatePage(&new_extent));
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+TEST(DiskManagerTest, ConcurrentTest) {
+  const int num_threads = 4;
+  const int num_pages = 64;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([disk_manager, tid]() {
+      char page_data[PAGE_SIZE];
+      char page_buffer[PAGE_SIZE];
+      // every thread owns the pages congruent to its id
+      for (int round = 0; round < 10; round++) {
+        for (page_id_t page_id = tid; page_id < num_pages;
+             page_id += num_threads) {
+          memset(page_data, page_id + round, PAGE_SIZE);
+          disk_manager->WritePage(page_id, page_data);
+          disk_manager->ReadPage(page_id, page_buffer);
+          EXPECT_EQ(0, memcmp(page_data, page_buffer, PAGE_SIZE));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
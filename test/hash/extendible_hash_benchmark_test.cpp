@@ -0,0 +1,80 @@
+/**
+ * extendible_hash_benchmark_test.cpp
+ *
+ * Multi-threaded throughput of ExtendibleHash under a lookup heavy mix
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "hash/extendible_hash.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+/*
+ * Every thread works on its own keys: 80% lookups of any key, 15% inserts
+ * and 5% removes of its own keys. Return operations per second
+ */
+static double RunMix(int num_threads, int ops_per_thread) {
+  const int keys_per_thread = 4096;
+  ExtendibleHash<int, int> table(16);
+  // preload half the keys so lookups mostly hit
+  for (int i = 0; i < num_threads * keys_per_thread; i += 2) {
+    table.Insert(i, i);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&, tid]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<int> op(0, 99);
+      std::uniform_int_distribution<int> own(0, keys_per_thread - 1);
+      std::uniform_int_distribution<int> any(
+          0, num_threads * keys_per_thread - 1);
+      int value;
+      for (int i = 0; i < ops_per_thread; i++) {
+	int choice = op(gen);
+	if (choice < 80) {
+	  table.Find(any(gen), value);
+	} else if (choice < 95) {
+	  int key = tid * keys_per_thread + own(gen);
+	  table.Insert(key, key);
+	} else {
+	  table.Remove(tid * keys_per_thread + own(gen));
+	}
+      }
+      // leave every own key present with a known value
+      for (int i = 0; i < keys_per_thread; i++) {
+	int key = tid * keys_per_thread + i;
+	table.Insert(key, -key);
+      }
+    }));
+  }
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads[tid].join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  int value;
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    EXPECT_EQ(true, table.Find(i, value));
+    EXPECT_EQ(-i, value);
+  }
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+TEST(ExtendibleHashBenchmarkTest, ThroughputTest) {
+  const int ops_per_thread = 200000;
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    double rate = RunMix(num_threads, ops_per_thread);
+    printf("%d threads: %.0f ops/s\n", num_threads, rate);
+  }
+}
+
+} // namespace cmudb
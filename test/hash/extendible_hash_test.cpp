@@ -202,7 +202,8 @@ namespace cmudb {
       for (int i = 0; i < num_threads; i++) {
 	threads[i].join();
       }
-      EXPECT_EQ(test->GetGlobalDepth(), 6);
+      // removes merge buckets back, the directory never grows past its peak
+      EXPECT_GE(6, test->GetGlobalDepth());
       int val;
       EXPECT_EQ(0, test->Find(0, val));
       EXPECT_EQ(1, test->Find(8, val));
@@ -212,4 +213,43 @@ namespace cmudb {
     }
   }
 
+  TEST(ExtendibleHashTest, MergeAndShrinkTest) {
+    ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(4);
+
+    for (int i = 0; i < 1024; i++) {
+      test->Insert(i, i);
+    }
+    int peak_depth = test->GetGlobalDepth();
+    EXPECT_LE(8, peak_depth);
+
+    // removing most keys merges buckets and halves the directory
+    for (int i = 0; i < 1024; i++) {
+      if (i >= 16) {
+	EXPECT_EQ(true, test->Remove(i));
+      }
+    }
+    EXPECT_GT(peak_depth, test->GetGlobalDepth());
+    int value;
+    for (int i = 0; i < 1024; i++) {
+      EXPECT_EQ(i < 16, test->Find(i, value));
+    }
+
+    // a steady churn keeps the directory at the same size
+    int depth = test->GetGlobalDepth();
+    for (int round = 0; round < 100; round++) {
+      test->Insert(100, 100);
+      test->Remove(100);
+      EXPECT_EQ(depth, test->GetGlobalDepth());
+    }
+
+    // and an empty table is a single bucket again
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(true, test->Remove(i));
+    }
+    EXPECT_EQ(0, test->GetGlobalDepth());
+    EXPECT_EQ(1, test->GetNumBuckets());
+
+    delete test;
+  }
+
 } // namespace cmudb
@@ -0,0 +1,97 @@
+/**
+ * b_plus_tree_benchmark_test.cpp
+ *
+ * Multi-threaded point lookup throughput of BPlusTree, optimistic against
+ * latch crabbing
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/b_plus_tree.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+/*
+ * Every thread looks up random keys of the tree, all of them present. Return
+ * lookups per second
+ */
+static double
+RunLookups(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+           int64_t num_keys, int num_threads, int ops_per_thread) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&, tid]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<int64_t> any(0, num_keys - 1);
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int i = 0; i < ops_per_thread; i++) {
+        int64_t key = any(gen);
+        rids.clear();
+        index_key.SetFromInteger(key);
+        tree.GetValue(index_key, rids);
+        ASSERT_EQ(1u, rids.size());
+        EXPECT_EQ(key, rids[0].GetSlotNum());
+      }
+    }));
+  }
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads[tid].join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+TEST(BPlusTreeBenchmarkTest, LookupThroughputTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // every page of the tree stays resident
+  BufferPoolManager *bpm = new BufferPoolManager(4000, disk_manager, nullptr, 8);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  const int64_t num_keys = 20000;
+  Transaction *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  delete transaction;
+
+  const int ops_per_thread = 50000;
+  int attempts = OPTIMISTIC_LOOKUP_ATTEMPTS;
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    OPTIMISTIC_LOOKUP_ATTEMPTS = attempts;
+    double optimistic = RunLookups(tree, num_keys, num_threads, ops_per_thread);
+    OPTIMISTIC_LOOKUP_ATTEMPTS = 0;
+    double crabbing = RunLookups(tree, num_keys, num_threads, ops_per_thread);
+    printf("%d threads: optimistic %.0f lookups/s, crabbing %.0f lookups/s\n",
+           num_threads, optimistic, crabbing);
+  }
+  OPTIMISTIC_LOOKUP_ATTEMPTS = attempts;
+  EXPECT_EQ(1, bpm->PinnedNum());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
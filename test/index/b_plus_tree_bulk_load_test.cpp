@@ -0,0 +1,222 @@
+/**
+ * b_plus_tree_bulk_load_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/b_plus_tree.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+typedef BPlusTree<GenericKey<8>, RID, GenericComparator<8>> BPlusTree8;
+
+// pages allocated so far
+static int AllocatedPages(DiskManager *disk_manager) {
+  int count = 0;
+  for (page_id_t page_id = 0; page_id < 100000; page_id++) {
+    if (disk_manager->IsAllocated(page_id)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void CheckKeys(BPlusTree8 &tree, int64_t num_keys) {
+  EXPECT_EQ(true, tree.CheckIntegrity());
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    ASSERT_EQ(1u, rids.size());
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+  // the leaf chain is complete and in order
+  int64_t current_key = 0;
+  if (num_keys > 0) {
+    for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+      EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+      current_key++;
+    }
+  }
+  EXPECT_EQ(num_keys, current_key);
+}
+
+TEST(BPlusTreeBulkLoadTests, SizeTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  // pairs of a full leaf, keys taking their whole width
+  int leaf_capacity =
+      BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>::Capacity() /
+      BPlusTreeLeafPage<GenericKey<8>, RID,
+                        GenericComparator<8>>::MaxEntrySize();
+
+  // empty, one leaf, the last two leaves merged or shared, several levels
+  for (int64_t num_keys : {0, 1, leaf_capacity + 1, 2 * leaf_capacity - 1,
+                           2 * leaf_capacity + 3, 10000}) {
+    for (double fill_factor : {0.5, 0.9, 1.0}) {
+      remove("test.db");
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+      {
+        BPlusTree8 tree("foo_pk", bpm, comparator);
+        std::vector<std::pair<GenericKey<8>, RID>> items(num_keys);
+        for (int64_t key = 0; key < num_keys; key++) {
+          items[key].first.SetFromInteger(key);
+          items[key].second.Set(0, key);
+        }
+        std::shuffle(items.begin(), items.end(), std::mt19937(num_keys));
+        EXPECT_EQ(true, tree.BulkLoad(items, fill_factor));
+        EXPECT_EQ(0, bpm->PinnedNum());
+        CheckKeys(tree, num_keys);
+      }
+      delete bpm;
+      delete disk_manager;
+    }
+  }
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+TEST(BPlusTreeBulkLoadTests, CompareInsertTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  const int64_t num_keys = 10000;
+  int pages[2];
+
+  for (int bulk_load = 0; bulk_load < 2; bulk_load++) {
+    remove("test.db");
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    {
+      BPlusTree8 tree("foo_pk", bpm, comparator);
+      Transaction transaction(0);
+      GenericKey<8> index_key;
+      RID rid;
+      int64_t key = 0;
+      if (bulk_load) {
+        EXPECT_EQ(true, tree.BulkLoad([&](GenericKey<8> &k, RID &r) {
+          if (key == num_keys) {
+            return false;
+          }
+          k.SetFromInteger(key);
+          r.Set(0, key);
+          key++;
+          return true;
+        }));
+      } else {
+        for (; key < num_keys; key++) {
+          index_key.SetFromInteger(key);
+          rid.Set(0, key);
+          tree.Insert(index_key, rid, &transaction);
+        }
+      }
+      CheckKeys(tree, num_keys);
+      pages[bulk_load] = AllocatedPages(disk_manager);
+
+      // a bulk loaded tree takes inserts and removes as usual
+      for (int64_t key = num_keys; key < num_keys + 500; key++) {
+        index_key.SetFromInteger(key);
+        rid.Set(0, key);
+        EXPECT_EQ(true, tree.Insert(index_key, rid, &transaction));
+      }
+      for (int64_t key = num_keys; key < num_keys + 500; key++) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key, &transaction);
+      }
+      CheckKeys(tree, num_keys);
+    }
+    delete bpm;
+    delete disk_manager;
+  }
+  EXPECT_LT(pages[1], pages[0]);
+
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+TEST(BPlusTreeBulkLoadTests, RejectTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  {
+    BPlusTree8 tree("foo_pk", bpm, comparator);
+    int before = AllocatedPages(disk_manager);
+    // duplicate keys leave the tree empty, and the pages written are freed
+    std::vector<std::pair<GenericKey<8>, RID>> items(1000);
+    for (int64_t key = 0; key < 1000; key++) {
+      items[key].first.SetFromInteger(key == 999 ? 0 : key);
+    }
+    EXPECT_EQ(false, tree.BulkLoad(items));
+    EXPECT_EQ(true, tree.IsEmpty());
+    EXPECT_EQ(0, bpm->PinnedNum());
+    EXPECT_EQ(before, AllocatedPages(disk_manager));
+
+    // only an empty tree can be loaded
+    items.resize(10);
+    for (int64_t key = 0; key < 10; key++) {
+      items[key].first.SetFromInteger(key);
+      items[key].second.Set(0, key);
+    }
+    EXPECT_EQ(true, tree.BulkLoad(items));
+    EXPECT_EQ(false, tree.BulkLoad(items));
+    CheckKeys(tree, 10);
+  }
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+TEST(BPlusTreeBulkLoadTests, IndexTest) {
+  Schema *schema = ParseCreateStatement("a bigint");
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  {
+    BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+        new IndexMetadata("foo_pk", "foo", schema, {0}), bpm);
+    auto entries_from = [&](int64_t first, int64_t last) {
+      std::vector<std::pair<Tuple, RID>> entries;
+      for (int64_t key = last; key >= first; key--) {
+        std::vector<Value> values{Value(TypeId::BIGINT, key)};
+        entries.emplace_back(Tuple(values, index.GetKeySchema()),
+                             RID(0, static_cast<int>(key)));
+      }
+      return entries;
+    };
+    // the first load builds the tree, the second one only can insert, and
+    // without a transaction of its own
+    auto entries = entries_from(0, 999);
+    index.BulkLoad(entries);
+    entries = entries_from(500, 1499);
+    index.BulkLoad(entries);
+    EXPECT_EQ(0, bpm->PinnedNum());
+    for (int64_t key = 0; key < 1500; key++) {
+      std::vector<RID> rids;
+      std::vector<Value> values{Value(TypeId::BIGINT, key)};
+      index.ScanKey(Tuple(values, index.GetKeySchema()), rids);
+      ASSERT_EQ(1u, rids.size());
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+  delete schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+} // namespace cmudb
@@ -103,6 +103,44 @@ namespace cmudb {
     delete transaction;
   }
 
+// helper function to insert some keys and delete others at the same time
+  void MixHelperSplit(
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+    const std::vector<int64_t> &keys, const std::vector<int64_t> &remove_keys,
+    int total_threads, uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    RID rid;
+    Transaction *transaction = new Transaction(0);
+    for (size_t i = 0; i < std::max(keys.size(), remove_keys.size()); i++) {
+      if (i < keys.size() && (uint64_t)keys[i] % total_threads == thread_itr) {
+	rid.Set((int32_t)(keys[i] >> 32), keys[i] & 0xFFFFFFFF);
+	index_key.SetFromInteger(keys[i]);
+	EXPECT_EQ(true, tree.Insert(index_key, rid, transaction));
+      }
+      if (i < remove_keys.size() &&
+	  (uint64_t)remove_keys[i] % total_threads == thread_itr) {
+	index_key.SetFromInteger(remove_keys[i]);
+	tree.Remove(index_key, transaction);
+      }
+    }
+    delete transaction;
+  }
+
+// helper function to look keys up, each one must be found
+  void LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+		    const std::vector<int64_t> &keys,
+		    __attribute__((unused)) uint64_t thread_itr = 0) {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    for (auto key : keys) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      tree.GetValue(index_key, rids);
+      ASSERT_EQ(1u, rids.size());
+      EXPECT_EQ(key & 0xFFFFFFFF, rids[0].GetSlotNum());
+    }
+  }
+
   TEST(BPlusTreeConcurrentTest, InsertTest1) {
     // create KeyComparator and index schema
     Schema *key_schema = ParseCreateStatement("a bigint");
@@ -412,4 +450,102 @@ namespace cmudb {
     remove("test.log");
   }
 
+  TEST(BPlusTreeConcurrentTest, InsertDeleteTest) {
+    // create KeyComparator and index schema
+    Schema *key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema);
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    // create b+ tree
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+							     comparator);
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    std::vector<int64_t> keys, remove_keys;
+    for (int64_t key = 0; key < 5000; key++) {
+      remove_keys.push_back(key);
+      keys.push_back(key + 5000);
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+    std::random_shuffle(remove_keys.begin(), remove_keys.end());
+    InsertHelper(tree, remove_keys);
+    // leaves split and merge while other writers only latch their leaf
+    LaunchParallelTest(8, MixHelperSplit, std::ref(tree), keys, remove_keys, 8);
+    EXPECT_EQ(true, tree.CheckIntegrity());
+    EXPECT_EQ(1, bpm->PinnedNum());
+
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < 10000; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      tree.GetValue(index_key, rids);
+      EXPECT_EQ(key < 5000 ? 0u : 1u, rids.size());
+    }
+    int64_t current_key = 5000;
+    for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+      EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+      current_key++;
+    }
+    EXPECT_EQ(10000, current_key);
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+    delete key_schema;
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+
+  TEST(BPlusTreeConcurrentTest, LookupTest) {
+    // create KeyComparator and index schema
+    Schema *key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema);
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    // create b+ tree
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+							     comparator);
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    std::vector<int64_t> even_keys, odd_keys;
+    for (int64_t key = 0; key < 4000; key += 2) {
+      even_keys.push_back(key);
+      odd_keys.push_back(key + 1);
+    }
+    std::random_shuffle(odd_keys.begin(), odd_keys.end());
+    InsertHelper(tree, even_keys);
+    // readers latch nothing while pages split under them
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+      readers.emplace_back([&]() {
+        for (int round = 0; round < 5; round++) {
+          LookupHelper(tree, even_keys);
+        }
+      });
+    }
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), odd_keys, 4);
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    EXPECT_EQ(true, tree.CheckIntegrity());
+    EXPECT_EQ(1, bpm->PinnedNum());
+    LookupHelper(tree, odd_keys);
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+    delete key_schema;
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+
 } // namespace cmudb
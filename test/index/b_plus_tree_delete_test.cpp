@@ -1,6 +1,8 @@
 /*
  * b_plus_tree_delete_test.cpp
  */
+#include <algorithm>
+#include <cstdio>
 #include <random>
 
 #include "gtest/gtest.h"
@@ -358,4 +360,77 @@ namespace cmudb {
     remove("test.db");
     remove("test.log");
   } 
+
+  TEST(BPlusTreeDeleteTests, VarcharTest) {
+    // long keys sharing most of their bytes: pages split and merge by the
+    // bytes of their keys
+    Schema *key_schema = ParseCreateStatement("a varchar(60)");
+    GenericComparator<64> comparator(key_schema);
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(500, disk_manager);
+
+    BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+
+    RID rid;
+    Transaction *transaction = new Transaction(0);
+
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    auto url_key = [&](int i) {
+      char url[64];
+      snprintf(url, sizeof(url), "https://example.com/%s/%06d", i % 2 ? "users" : "groups", i);
+      std::vector<Value> values{Value(TypeId::VARCHAR, std::string(url))};
+      GenericKey<64> key;
+      key.SetFromKey(Tuple(values, key_schema), key_schema);
+      return key;
+    };
+
+    const int num_keys = 2000;
+    std::vector<int> keys(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+    // insert phase
+    for (int key : keys) {
+      rid.Set(0, key);
+      EXPECT_EQ(true, tree.Insert(url_key(key), rid, transaction));
+    }
+    EXPECT_EQ(tree.CheckIntegrity(), true);
+
+    // delete phase, two keys out of three
+    for (int key : keys) {
+      if (key % 3 != 0) {
+        tree.Remove(url_key(key), transaction);
+      }
+    }
+    EXPECT_EQ(tree.CheckIntegrity(), true);
+    EXPECT_EQ(1, bpm->PinnedNum());
+
+    // find phase
+    std::vector<RID> rids;
+    for (int key = 0; key < num_keys; key++) {
+      rids.clear();
+      tree.GetValue(url_key(key), rids);
+      if (key % 3 != 0) {
+        EXPECT_EQ(0, rids.size());
+        continue;
+      }
+      ASSERT_EQ(1, rids.size());
+      EXPECT_EQ(key, rids[0].GetSlotNum());
+    }
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    EXPECT_EQ(0, bpm->PinnedNum());
+    delete transaction;
+    delete disk_manager;
+    delete bpm;
+    delete key_schema;
+    remove("test.db");
+    remove("test.log");
+  }
 }
@@ -196,4 +196,54 @@ namespace cmudb {
     remove("test.log");
   }  
   
+  TEST(BPlusTreeIteratorTests, ReadAheadTest) {
+    // create KeyComparator and index schema
+    Schema *key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema);
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    // far fewer frames than leaves, the scan reads most of them from disk
+    BufferPoolManager *bpm = new BufferPoolManager(40, disk_manager);
+    // create b+ tree
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+							     comparator);
+    GenericKey<8> index_key;
+    RID rid;
+    // create transaction
+    Transaction *transaction = new Transaction(0);
+
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    for (int64_t key = 0; key < 5000; key++) {
+      rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+
+    // the window never changes what the scan sees
+    for (size_t max_read_ahead : {0, 2, 8}) {
+      int64_t i = 0;
+      auto itr = tree.Begin();
+      itr.SetMaxReadAhead(max_read_ahead);
+      for (; !itr.isEnd(); ++itr) {
+	EXPECT_EQ(i, (*itr).first.ToString());
+	i++;
+      }
+      EXPECT_EQ(5000, i);
+    }
+    // a prefetch may still be finishing its callback
+    disk_manager->WaitAsync();
+    EXPECT_EQ(1, bpm->PinnedNum());
+
+    bpm->UnpinPage(page_id, true);
+    delete transaction;
+    delete bpm;
+    delete disk_manager;
+    delete key_schema;
+    remove("test.db");
+    remove("test.log");
+  }
 }
@@ -0,0 +1,175 @@
+/**
+ * b_plus_tree_page_test.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "page/b_plus_tree_internal_page.h"
+#include "page/b_plus_tree_leaf_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(BPlusTreePageTests, PartitionPointTest) {
+  for (int size = 0; size < 70; size++) {
+    std::vector<int> items(size);
+    for (int i = 0; i < size; i++) {
+      items[i] = 2 * i;
+    }
+    for (int key = -1; key <= 2 * size; key++) {
+      int calls = 0;
+      int index = PartitionPoint(items.data(), size, [&](int item) {
+        calls++;
+        return item < key;
+      });
+      EXPECT_EQ(key <= 0 ? 0 : (key + 1) / 2, index);
+      // logarithmic, plus the linear tail
+      int log = 0;
+      while ((1 << log) < size) {
+        log++;
+      }
+      EXPECT_LE(calls, log + LINEAR_SEARCH_SIZE);
+    }
+  }
+}
+
+TEST(BPlusTreePageTests, SearchTest) {
+  // a realistic page size, hundreds of keys per page
+  int page_size = PAGE_SIZE;
+  PAGE_SIZE = 4096;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<char> data(PAGE_SIZE);
+  GenericKey<8> index_key;
+
+  auto leaf = reinterpret_cast<
+      BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(
+      data.data());
+  leaf->Init(1);
+  int size = leaf->GetMaxSize();
+  EXPECT_LT(200, size);
+  // odd keys, inserted out of order
+  for (int i = 0; i < size; i++) {
+    int64_t key = 2 * ((i * 7) % size) + 1;
+    index_key.SetFromInteger(key);
+    leaf->Insert(index_key, RID(0, key), comparator);
+  }
+  EXPECT_EQ(size, leaf->GetSize());
+  for (int64_t key = 0; key <= 2 * size; key++) {
+    index_key.SetFromInteger(key);
+    RID rid;
+    EXPECT_EQ(key % 2 == 1, leaf->Lookup(index_key, rid, comparator));
+    if (key % 2 == 1) {
+      EXPECT_EQ(key, rid.GetSlotNum());
+    }
+    EXPECT_EQ(key == 2 * size ? -1 : key / 2,
+              leaf->KeyIndex(index_key, comparator));
+  }
+  index_key.SetFromInteger(5);
+  EXPECT_EQ(size - 1, leaf->RemoveAndDeleteRecord(index_key, comparator));
+  RID rid;
+  EXPECT_EQ(false, leaf->Lookup(index_key, rid, comparator));
+  index_key.SetFromInteger(4);
+  EXPECT_EQ(size - 1, leaf->RemoveAndDeleteRecord(index_key, comparator));
+
+  // child i holds the keys from 10 * i on
+  memset(data.data(), 0, PAGE_SIZE);
+  auto internal = reinterpret_cast<
+      BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>> *>(
+      data.data());
+  internal->Init(1);
+  size = internal->GetMaxSize();
+  for (int i = 0; i < size; i++) {
+    index_key.SetFromInteger(10 * i);
+    internal->Append(index_key, 100 + i);
+  }
+  for (int64_t key = -5; key < 10 * size + 5; key++) {
+    index_key.SetFromInteger(key);
+    int64_t child = key < 0 ? 0 : std::min<int64_t>(key / 10, size - 1);
+    EXPECT_EQ(100 + child, internal->Lookup(index_key, comparator));
+  }
+  delete key_schema;
+  PAGE_SIZE = page_size;
+}
+
+// long keys sharing most of their bytes, in the order of i
+static GenericKey<64> UrlKey(Schema *key_schema, int i) {
+  char url[64];
+  snprintf(url, sizeof(url), "https://example.com/users/%06d/profile", i);
+  std::vector<Value> values{Value(TypeId::VARCHAR, std::string(url))};
+  GenericKey<64> key;
+  key.SetFromKey(Tuple(values, key_schema), key_schema);
+  return key;
+}
+
+TEST(BPlusTreePageTests, CompressionTest) {
+  int page_size = PAGE_SIZE;
+  PAGE_SIZE = 4096;
+  Schema *key_schema = ParseCreateStatement("a varchar(60)");
+  GenericComparator<64> comparator(key_schema);
+  std::vector<char> data(PAGE_SIZE), sibling_data(PAGE_SIZE);
+  typedef BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>
+      LeafPage;
+
+  // only what follows the shared prefix is stored
+  auto leaf = reinterpret_cast<LeafPage *>(data.data());
+  leaf->Init(1);
+  int size = 0;
+  while (leaf->CanInsert(UrlKey(key_schema, 2 * size))) {
+    leaf->Insert(UrlKey(key_schema, 2 * size), RID(0, 2 * size), comparator);
+    size++;
+  }
+  EXPECT_EQ(size, leaf->GetSize());
+  EXPECT_LT(3 * leaf->GetMaxSize(), size);
+  RID rid;
+  for (int i = 0; i < 2 * size; i++) {
+    EXPECT_EQ(i % 2 == 0, leaf->Lookup(UrlKey(key_schema, i), rid, comparator));
+  }
+  // a key outside the prefix would make every suffix longer
+  GenericKey<64> other = UrlKey(key_schema, 0);
+  other.data[0] = 'z';
+  EXPECT_EQ(false, leaf->CanInsert(other));
+
+  // split by bytes, the separator is as short as it gets
+  auto sibling = reinterpret_cast<LeafPage *>(sibling_data.data());
+  sibling->Init(2);
+  GenericKey<64> separator = leaf->InsertAndMoveHalfTo(
+      UrlKey(key_schema, 1), RID(0, 1), sibling, comparator);
+  EXPECT_EQ(size + 1, leaf->GetSize() + sibling->GetSize());
+  EXPECT_GE(1, std::abs(leaf->GetSize() - sibling->GetSize()));
+  EXPECT_EQ(2, leaf->GetNextPageId());
+  GenericKey<64> last = leaf->KeyAt(leaf->GetSize() - 1);
+  GenericKey<64> first = sibling->KeyAt(0);
+  EXPECT_GT(0, comparator(last, separator));
+  EXPECT_GE(0, comparator(separator, first));
+  EXPECT_EQ(CommonPrefix(last, first) + 1, KeyLength(separator));
+  EXPECT_EQ(true, leaf->Lookup(UrlKey(key_schema, 1), rid, comparator));
+  EXPECT_EQ(1, rid.GetSlotNum());
+
+  // separators take the place of whole keys in internal pages
+  memset(data.data(), 0, PAGE_SIZE);
+  auto internal = reinterpret_cast<
+      BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>> *>(
+      data.data());
+  internal->Init(1);
+  size = 0;
+  GenericKey<64> key = Separator(UrlKey(key_schema, 0), UrlKey(key_schema, 1));
+  while (internal->CanInsert(key)) {
+    internal->Append(key, 100 + size);
+    size++;
+    key = Separator(UrlKey(key_schema, 10 * size - 1), UrlKey(key_schema, 10 * size));
+  }
+  EXPECT_LT(internal->GetMaxSize() + internal->GetMaxSize() / 2, size);
+  for (int i = 0; i < 10 * size; i++) {
+    EXPECT_EQ(100 + i / 10, internal->Lookup(UrlKey(key_schema, i), comparator));
+  }
+  delete key_schema;
+  PAGE_SIZE = page_size;
+}
+
+} // namespace cmudb
@@ -0,0 +1,102 @@
+/**
+ * disk_extendible_hash_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/disk_extendible_hash.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskExtendibleHashTest, SampleTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  // page ids continue where a database left behind stopped
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // page 0 is unused, page 1 is the header page
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  bpm->UnpinPage(page_id, false);
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  EXPECT_EQ(HEADER_PAGE_ID, page_id);
+  header_page->Init();
+  bpm->UnpinPage(page_id, true);
+
+  DiskExtendibleHash<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  EXPECT_EQ(true, table.IsEmpty());
+
+  GenericKey<8> index_key;
+  RID rid;
+  // enough keys to split buckets up to a full directory and chain overflows
+  for (int64_t key = 0; key < 10000; key++) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.Insert(index_key, rid));
+  }
+  EXPECT_EQ(0, bpm->PinnedNum());
+  EXPECT_EQ(false, table.IsEmpty());
+  EXPECT_LT(0, table.GetGlobalDepth());
+
+  // no duplicate keys
+  index_key.SetFromInteger(42);
+  EXPECT_EQ(false, table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 10000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+    EXPECT_EQ(1, rids.size());
+    EXPECT_EQ(key & 0xFFFFFFFF, rids[0].GetSlotNum());
+  }
+  index_key.SetFromInteger(10000);
+  EXPECT_EQ(false, table.GetValue(index_key, rids));
+
+  // reopen the same table from its directory page
+  page_id_t directory_page_id;
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_EQ(true, header_page->GetRootId("foo_pk", directory_page_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  EXPECT_EQ(table.GetDirectoryPageId(), directory_page_id);
+  DiskExtendibleHash<GenericKey<8>, RID, GenericComparator<8>> reopened(
+      "foo_pk", bpm, comparator, directory_page_id);
+  uint32_t global_depth = table.GetGlobalDepth();
+  EXPECT_EQ(global_depth, reopened.GetGlobalDepth());
+
+  // removing most keys merges buckets and shrinks the directory
+  for (int64_t key = 16; key < 10000; key++) {
+    index_key.SetFromInteger(key);
+    reopened.Remove(index_key);
+  }
+  EXPECT_EQ(0, bpm->PinnedNum());
+  EXPECT_GT(global_depth, reopened.GetGlobalDepth());
+  for (int64_t key = 0; key < 10000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key < 16, reopened.GetValue(index_key, rids));
+  }
+
+  // removing everything leaves a single bucket
+  for (int64_t key = 0; key < 16; key++) {
+    index_key.SetFromInteger(key);
+    reopened.Remove(index_key);
+  }
+  EXPECT_EQ(0, reopened.GetGlobalDepth());
+  EXPECT_EQ(0, bpm->PinnedNum());
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -0,0 +1,155 @@
+/**
+ * generic_key_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "index/generic_key.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// memcmp of the encoded keys must agree with comparing the values
+template <size_t KeySize>
+static void CheckOrder(Schema *schema, std::vector<std::vector<Value>> &rows) {
+  GenericComparator<KeySize> comparator(schema);
+  std::vector<GenericKey<KeySize>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], schema), schema);
+  }
+  for (size_t i = 0; i < rows.size(); i++) {
+    for (size_t j = 0; j < rows.size(); j++) {
+      int expected = 0;
+      for (size_t k = 0; k < rows[i].size() && expected == 0; k++) {
+        if (rows[i][k].CompareLessThan(rows[j][k]) == CMP_TRUE) {
+          expected = -1;
+        } else if (rows[i][k].CompareGreaterThan(rows[j][k]) == CMP_TRUE) {
+          expected = 1;
+        }
+      }
+      int result = comparator(keys[i], keys[j]);
+      EXPECT_EQ(expected, (result > 0) - (result < 0)) << i << " " << j;
+    }
+  }
+}
+
+TEST(GenericKeyTest, IntegerTest) {
+  Schema *schema = ParseCreateStatement("a tinyint, b smallint, c integer");
+  std::vector<std::vector<Value>> rows;
+  for (int a : {-100, -1, 0, 1, 100}) {
+    for (int b : {-30000, -256, -1, 0, 255, 256, 30000}) {
+      for (int c : {-2000000000, -65536, -1, 0, 1, 65535, 2000000000}) {
+        rows.push_back({Value(TypeId::TINYINT, static_cast<int8_t>(a)),
+                        Value(TypeId::SMALLINT, static_cast<int16_t>(b)),
+                        Value(TypeId::INTEGER, static_cast<int32_t>(c))});
+      }
+    }
+  }
+  CheckOrder<8>(schema, rows);
+  delete schema;
+
+  GenericKey<8> key;
+  for (int64_t i : {INT64_MIN + 1, -256L, -1L, 0L, 1L, 256L, INT64_MAX}) {
+    key.SetFromInteger(i);
+    EXPECT_EQ(i, key.ToString());
+  }
+}
+
+TEST(GenericKeyTest, DecimalTest) {
+  Schema *schema = ParseCreateStatement("a double");
+  std::vector<std::vector<Value>> rows;
+  for (double a : {-1e300, -2.5, -1.0, -1e-300, 0.0, 1e-300, 0.5, 1.0, 1e300}) {
+    rows.push_back({Value(TypeId::DECIMAL, a)});
+  }
+  CheckOrder<8>(schema, rows);
+  delete schema;
+}
+
+TEST(GenericKeyTest, VarcharTest) {
+  Schema *schema = ParseCreateStatement("a varchar(16), b bigint");
+  std::vector<std::vector<Value>> rows;
+  for (std::string a : {"", "a", "ab", "abc", "b", "ba", "zzzz"}) {
+    for (int64_t b : {-5L, 0L, 5L}) {
+      rows.push_back(
+          {Value(TypeId::VARCHAR, a), Value(TypeId::BIGINT, b)});
+    }
+  }
+  CheckOrder<32>(schema, rows);
+
+  // an embedded 0 sorts below every other character
+  std::string zero("a\0b", 3);
+  std::vector<Value> lhs{Value(TypeId::VARCHAR, zero),
+                         Value(TypeId::BIGINT, static_cast<int64_t>(0))};
+  std::vector<Value> rhs{Value(TypeId::VARCHAR, std::string("a\x01")),
+                         Value(TypeId::BIGINT, static_cast<int64_t>(0))};
+  std::vector<Value> prefix{Value(TypeId::VARCHAR, std::string("a")),
+                            Value(TypeId::BIGINT, static_cast<int64_t>(9))};
+  GenericKey<32> lhs_key, rhs_key, prefix_key;
+  lhs_key.SetFromKey(Tuple(lhs, schema), schema);
+  rhs_key.SetFromKey(Tuple(rhs, schema), schema);
+  prefix_key.SetFromKey(Tuple(prefix, schema), schema);
+  GenericComparator<32> comparator(schema);
+  EXPECT_GT(0, comparator(lhs_key, rhs_key));
+  EXPECT_GT(0, comparator(prefix_key, lhs_key));
+  delete schema;
+}
+
+// keys are sized from the columns, and a longer one is refused, not cut off
+TEST(GenericKeyTest, KeySizeTest) {
+  Schema *schema = ParseCreateStatement("a varchar(6), b bigint");
+  EXPECT_EQ(16u, GetEncodedKeySize(schema));
+  auto row = [](const std::string &text) {
+    return std::vector<Value>{Value(TypeId::VARCHAR, text),
+                              Value(TypeId::BIGINT, static_cast<int64_t>(1))};
+  };
+  GenericKey<16> key;
+  EXPECT_TRUE(key.SetFromKey(Tuple(row("abcdef"), schema), schema));
+  EXPECT_TRUE(key.SetFromKey(Tuple(row(""), schema), schema));
+  // would only differ past the end of the key
+  EXPECT_FALSE(key.SetFromKey(Tuple(row("abcdefgh"), schema), schema));
+  EXPECT_FALSE(key.SetFromKey(Tuple(row("abcdefgi"), schema), schema));
+  // escaping takes the room of a longer string
+  EXPECT_FALSE(
+      key.SetFromKey(Tuple(row(std::string("abc\0ef", 6)), schema), schema));
+  delete schema;
+}
+
+// the word comparisons must agree with memcmp over the whole key
+template <size_t KeySize> static void CheckWords(const std::string &sql) {
+  Schema *schema = ParseCreateStatement(sql);
+  GenericComparator<KeySize> comparator(schema);
+  // bytes past the encoded columns stay 0
+  size_t length = std::min<size_t>(KeySize, schema->GetLength());
+  std::vector<GenericKey<KeySize>> keys(200);
+  for (auto &key : keys) {
+    memset(key.data, 0, KeySize);
+    for (size_t i = 0; i < length; i++) {
+      // few distinct bytes, so that long common prefixes show up
+      key.data[i] = static_cast<char>((rand() % 3) * 0x7f);
+    }
+  }
+  for (auto &lhs : keys) {
+    for (auto &rhs : keys) {
+      int expected = memcmp(lhs.data, rhs.data, KeySize);
+      int result = comparator(lhs, rhs);
+      EXPECT_EQ((expected > 0) - (expected < 0), (result > 0) - (result < 0));
+    }
+  }
+  delete schema;
+}
+
+TEST(GenericKeyTest, ComparatorTest) {
+  CheckWords<4>("a integer");
+  CheckWords<8>("a bigint");
+  CheckWords<8>("a integer, b integer");
+  CheckWords<16>("a bigint, b smallint");
+  CheckWords<32>("a bigint, b bigint, c integer");
+  CheckWords<64>("a varchar(20), b bigint");
+}
+
+} // namespace cmudb
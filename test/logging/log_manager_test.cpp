@@ -1,9 +1,14 @@
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
+#include "logging/checkpoint_manager.h"
 #include "logging/common.h"
 #include "logging/log_recovery.h"
+#include "page/header_page.h"
+#include "page/table_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -57,6 +62,56 @@ TEST(LogManagerTest, BasicLogging) {
   remove("test.log");
 }
 
+TEST(LogManagerTest, AppendTest) {
+  remove("test.db");
+  remove("test.log");
+  StorageEngine *storage_engine = new StorageEngine("test.db");
+  LogManager *log_manager = storage_engine->log_manager_;
+  log_manager->RunFlushThread();
+
+  // a few times the log buffer, appenders keep going while it is written
+  const int record_size =
+      LogRecord(0, INVALID_LSN, LogRecordType::NEWPAGE, 0).GetSize();
+  const int num_threads = 4;
+  const int per_thread = 3 * LOG_BUFFER_SIZE / record_size / num_threads;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < per_thread; i++) {
+        LogRecord log_record(t, INVALID_LSN, LogRecordType::NEWPAGE,
+                             t * per_thread + i);
+        log_manager->AppendLogRecord(log_record);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  const int total = num_threads * per_thread;
+  EXPECT_EQ(total - 1, log_manager->GetPersistentLSN());
+
+  // every record is in the log file once
+  DiskManager *disk_manager = storage_engine->disk_manager_;
+  ASSERT_EQ(total * record_size, disk_manager->GetLogSize());
+  std::vector<char> log(total * record_size);
+  EXPECT_TRUE(disk_manager->ReadLog(log.data(), log.size(), 0));
+  std::vector<bool> seen(total, false);
+  for (int i = 0; i < total; i++) {
+    page_id_t page_id;
+    // the page id closes the record
+    memcpy(&page_id, log.data() + (i + 1) * record_size - sizeof(page_id_t),
+           sizeof(page_id_t));
+    ASSERT_TRUE(page_id >= 0 && page_id < total);
+    EXPECT_FALSE(seen[page_id]);
+    seen[page_id] = true;
+  }
+
+  delete storage_engine;
+  remove("test.db");
+  remove("test.log");
+}
+
 // actually LogRecovery
 TEST(LogManagerTest, RedoTestWithOneTxn) {
   StorageEngine *storage_engine = new StorageEngine("test.db");
@@ -124,4 +179,126 @@ TEST(LogManagerTest, RedoTestWithOneTxn) {
   remove("test.log");
 }
 
+TEST(LogManagerTest, CheckpointTest) {
+  remove("test.db");
+  remove("test.log");
+  // a new database comes with its header page
+  StorageEngine *storage_engine = new StorageEngine("test.db");
+  BufferPoolManager *bpm = storage_engine->buffer_pool_manager_;
+  LogManager *log_manager = storage_engine->log_manager_;
+  page_id_t page_id;
+  auto *header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_EQ(INVALID_LSN, header_page->GetCheckpointLSN());
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+
+  // the table page is not logged yet, log its inserts by hand
+  Schema *schema = ParseCreateStatement("a varchar, b smallint, c bigint");
+  Transaction *txn = storage_engine->transaction_manager_->Begin();
+  auto *page = static_cast<TablePage *>(bpm->NewPage(page_id));
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, nullptr);
+  auto insert = [&](const Tuple &tuple) {
+    RID rid;
+    EXPECT_TRUE(page->InsertTuple(tuple, rid, txn, nullptr, nullptr));
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(),
+                         LogRecordType::INSERT, rid, tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(log_record);
+    txn->SetPrevLSN(lsn);
+    page->SetLSN(lsn);
+    return rid;
+  };
+  Tuple tuple1 = ConstructTuple(schema);
+  RID rid1 = insert(tuple1);
+  bpm->UnpinPage(page_id, true);
+
+  CheckpointManager checkpoint_manager(storage_engine->transaction_manager_,
+                                       log_manager, bpm);
+  checkpoint_manager.Checkpoint();
+  EXPECT_EQ(0, bpm->DirtyNum());
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  // the begin record follows the insert
+  EXPECT_EQ(txn->GetPrevLSN() + 1, header_page->GetCheckpointLSN());
+  EXPECT_LT(0, header_page->GetCheckpointOffset());
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+
+  // a change after the checkpoint reaches the log only, then crash
+  page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+  Tuple tuple2 = ConstructTuple(schema);
+  RID rid2 = insert(tuple2);
+  bpm->UnpinPage(page_id, true);
+  log_manager->Flush();
+  delete txn;
+  delete storage_engine;
+
+  storage_engine = new StorageEngine("test.db");
+  LogRecovery *log_recovery = new LogRecovery(
+      storage_engine->disk_manager_, storage_engine->buffer_pool_manager_);
+  log_recovery->Redo();
+  page = static_cast<TablePage *>(
+      storage_engine->buffer_pool_manager_->FetchPage(page_id));
+  Tuple tuple;
+  EXPECT_TRUE(page->GetTuple(rid1, tuple, nullptr, nullptr));
+  EXPECT_EQ(0, memcmp(tuple1.GetData(), tuple.GetData(), tuple1.GetLength()));
+  EXPECT_TRUE(page->GetTuple(rid2, tuple, nullptr, nullptr));
+  EXPECT_EQ(0, memcmp(tuple2.GetData(), tuple.GetData(), tuple2.GetLength()));
+  storage_engine->buffer_pool_manager_->UnpinPage(page_id, false);
+
+  delete log_recovery;
+  delete schema;
+  delete storage_engine;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(LogManagerTest, LargeRecordTest) {
+  remove("test.db");
+  remove("test.log");
+  StorageEngine *storage_engine = new StorageEngine("test.db");
+  BufferPoolManager *bpm = storage_engine->buffer_pool_manager_;
+  LogManager *log_manager = storage_engine->log_manager_;
+  Schema *schema = ParseCreateStatement("a varchar, b smallint, c bigint");
+  page_id_t page_id;
+  auto *page = static_cast<TablePage *>(bpm->NewPage(page_id));
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, nullptr);
+  bpm->UnpinPage(page_id, true);
+  bpm->FlushPage(page_id);
+
+  // the dirty page table of a checkpoint may not fit in the log buffer
+  std::unordered_map<page_id_t, lsn_t> dirty_pages;
+  for (int i = 0; i < LOG_BUFFER_SIZE / 8; i++) {
+    dirty_pages[i] = i;
+  }
+  LogRecord checkpoint_record(LogRecordType::END_CHECKPOINT, dirty_pages, {});
+  EXPECT_LT(LOG_BUFFER_SIZE, checkpoint_record.GetSize());
+  log_manager->AppendLogRecord(checkpoint_record);
+
+  // an insert past it reaches the log only, then crash
+  page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+  Tuple tuple1 = ConstructTuple(schema);
+  RID rid;
+  EXPECT_TRUE(page->InsertTuple(tuple1, rid, nullptr, nullptr, nullptr));
+  LogRecord log_record(0, INVALID_LSN, LogRecordType::INSERT, rid, tuple1);
+  page->SetLSN(log_manager->AppendLogRecord(log_record));
+  bpm->UnpinPage(page_id, true);
+  log_manager->Flush();
+  delete storage_engine;
+
+  // recovery reads the large record whole, and gets past it
+  storage_engine = new StorageEngine("test.db");
+  LogRecovery *log_recovery = new LogRecovery(
+      storage_engine->disk_manager_, storage_engine->buffer_pool_manager_);
+  log_recovery->Redo();
+  page = static_cast<TablePage *>(
+      storage_engine->buffer_pool_manager_->FetchPage(page_id));
+  Tuple tuple;
+  EXPECT_TRUE(page->GetTuple(rid, tuple, nullptr, nullptr));
+  EXPECT_EQ(0, memcmp(tuple1.GetData(), tuple.GetData(), tuple1.GetLength()));
+  storage_engine->buffer_pool_manager_->UnpinPage(page_id, false);
+
+  delete log_recovery;
+  delete schema;
+  delete storage_engine;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace cmudb
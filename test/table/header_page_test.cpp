@@ -5,11 +5,12 @@
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace cmudb {
 
 TEST(HeaderPageTest, UnitTest) {
+  // room for all the records below
+  int page_size = PAGE_SIZE;
+  PAGE_SIZE = 4096;
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
@@ -54,5 +55,40 @@ TEST(HeaderPageTest, UnitTest) {
   delete disk_manager;
   remove("test.db");
   remove("test.log");
+  PAGE_SIZE = page_size;
+}
+
+TEST(HeaderPageTest, PageSizeTest) {
+  int page_size = PAGE_SIZE;
+  EXPECT_EQ(0, FileHeaderPage::ReadPageSize("test.db"));
+  for (int size : {4096, 8192, 16384}) {
+    PAGE_SIZE = size;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager(20, disk_manager);
+    page_id_t page_id;
+    auto *page = static_cast<FileHeaderPage *>(
+        buffer_pool_manager->NewPage(page_id));
+    EXPECT_EQ(FILE_HEADER_PAGE_ID, page_id);
+    page->Init();
+    EXPECT_EQ(size, page->GetPageSize());
+    buffer_pool_manager->UnpinPage(page_id, true);
+    buffer_pool_manager->FlushPage(page_id);
+    delete buffer_pool_manager;
+    delete disk_manager;
+
+    // found whatever the current page size
+    PAGE_SIZE = page_size;
+    EXPECT_EQ(size, FileHeaderPage::ReadPageSize("test.db"));
+    remove("test.db");
+    remove("test.log");
+  }
+
+  // anything else is an error, not a guess
+  FILE *file = fopen("test.db", "wb");
+  fputs("SQLite format 3", file);
+  fclose(file);
+  EXPECT_EQ(-1, FileHeaderPage::ReadPageSize("test.db"));
+  remove("test.db");
 }
 } // namespace cmudb
@@ -61,4 +61,52 @@ TEST(TupleTest, TableHeapTest) {
   delete disk_manager;
 }
 
+
+TEST(TupleTest, TableHeapScanTest) {
+  Schema *schema = ParseCreateStatement("a bigint, b varchar(16)");
+  Tuple tuple = ConstructTuple(schema);
+
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // much smaller than the table, the scan has to read most pages from disk
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(20, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                   log_manager, transaction);
+
+  RID rid;
+  std::vector<RID> rid_v;
+  for (int i = 0; i < 5000; ++i) {
+    table->InsertTuple(tuple, rid, transaction);
+    rid_v.push_back(rid);
+  }
+
+  // read ahead doesn't change what the scan sees, nor leaves pages pinned
+  for (int round = 0; round < 2; round++) {
+    size_t count = 0;
+    for (TableIterator itr = table->begin(transaction); itr != table->end();
+         ++itr) {
+      ASSERT_LT(count, rid_v.size());
+      EXPECT_EQ(rid_v[count].Get(), itr->GetRid().Get());
+      count++;
+    }
+    EXPECT_EQ(rid_v.size(), count);
+    // a prefetch may still be finishing its callback
+    disk_manager->WaitAsync();
+    EXPECT_EQ(0, buffer_pool_manager->PinnedNum());
+  }
+
+  remove("test.db"); // remove db file
+  remove("test.log");
+  delete schema;
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete transaction;
+  delete disk_manager;
+}
+
 } // namespace cmudb